@@ -1,5 +1,8 @@
 #include "xiao_syscall.h"
 
+#define CREATE_TRACE_POINTS
+#include "xiao_trace.h"
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("xiaojs");
 MODULE_DESCRIPTION("xiaojs kernel module - system call bridge");
@@ -24,6 +27,18 @@ static int __init xiao_syscall_init(void)
         goto fail_security;
     }
 
+    ret = xiao_audit_init();
+    if (ret) {
+        pr_err("xiao_syscall: failed to initialize audit subsystem\n");
+        goto fail_audit;
+    }
+
+    ret = xiao_stats_init();
+    if (ret) {
+        pr_err("xiao_syscall: failed to initialize dispatch statistics\n");
+        goto fail_stats;
+    }
+
     ret = xiao_fs_init();
     if (ret) {
         pr_err("xiao_syscall: failed to initialize filesystem subsystem\n");
@@ -36,6 +51,12 @@ static int __init xiao_syscall_init(void)
         goto fail_proc;
     }
 
+    ret = xiao_event_init();
+    if (ret) {
+        pr_err("xiao_syscall: failed to initialize process event subsystem\n");
+        goto fail_event;
+    }
+
     ret = xiao_sys_init();
     if (ret) {
         pr_err("xiao_syscall: failed to initialize system info subsystem\n");
@@ -54,6 +75,12 @@ static int __init xiao_syscall_init(void)
         goto fail_hardware;
     }
 
+    ret = xiao_sampler_init();
+    if (ret) {
+        pr_err("xiao_syscall: failed to initialize metrics sampler\n");
+        goto fail_sampler;
+    }
+
     ret = xiao_ipc_init();
     if (ret) {
         pr_err("xiao_syscall: failed to initialize IPC subsystem\n");
@@ -84,16 +111,24 @@ fail_proc_entry:
 fail_proc_dir:
     xiao_ipc_exit();
 fail_ipc:
+    xiao_sampler_exit();
+fail_sampler:
     xiao_hardware_exit();
 fail_hardware:
     xiao_net_exit();
 fail_net:
     xiao_sys_exit();
 fail_sys:
+    xiao_event_exit();
+fail_event:
     xiao_proc_exit();
 fail_proc:
     xiao_fs_exit();
 fail_fs:
+    xiao_stats_exit();
+fail_stats:
+    xiao_audit_exit();
+fail_audit:
     xiao_security_exit();
 fail_security:
     return ret;
@@ -109,11 +144,15 @@ static void __exit xiao_syscall_exit(void)
         remove_proc_entry(XIAO_PROC_DIR, NULL);
 
     xiao_ipc_exit();
+    xiao_sampler_exit();
     xiao_hardware_exit();
     xiao_net_exit();
     xiao_sys_exit();
+    xiao_event_exit();
     xiao_proc_exit();
     xiao_fs_exit();
+    xiao_stats_exit();
+    xiao_audit_exit();
     xiao_security_exit();
 
     pr_info("xiao_syscall: module cleanup complete\n");
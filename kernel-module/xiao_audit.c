@@ -0,0 +1,151 @@
+#include "xiao_syscall.h"
+
+/*
+ * Structured audit trail for bridge commands and capability changes.
+ * Records go into the per-CPU rings from xiao_ring.c, so logging a
+ * decision never takes a shared lock; readers drain them in batches.
+ */
+
+static struct xiao_ring_set xiao_audit_ring;
+static bool xiao_audit_ready;
+
+static void xiao_audit_emit(u32 cmd, u32 path_hash, u32 target_pid, u32 caps, s32 verdict)
+{
+    struct xiao_audit_record rec;
+
+    if (!READ_ONCE(xiao_audit_ready))
+        return;
+
+    rec.timestamp = ktime_get_ns();
+    rec.pid = current->tgid;
+    rec.uid = from_kuid_munged(&init_user_ns, current_uid());
+    rec.cmd = cmd;
+    rec.path_hash = path_hash;
+    rec.target_pid = target_pid;
+    rec.caps = caps;
+    rec.verdict = verdict;
+    rec.cpu = raw_smp_processor_id();
+
+    xiao_ring_write(&xiao_audit_ring, &rec);
+}
+
+void xiao_audit_command(const struct xiao_request *req, u32 caps, s32 verdict)
+{
+    u32 path_hash = 0;
+
+    switch (req->cmd) {
+    case XIAO_CMD_REQUEST_CAP:
+    case XIAO_CMD_REVOKE_CAP:
+        /* Logged with the resulting mask by xiao_audit_cap() */
+        return;
+
+    case XIAO_CMD_READ_AUDIT:
+        if (!verdict)
+            return;
+        break;
+
+    case XIAO_CMD_READ_FILE:
+    case XIAO_CMD_WRITE_FILE:
+    case XIAO_CMD_LIST_DIR:
+        path_hash = full_name_hash(NULL, req->data, strnlen(req->data, XIAO_MAX_PATH));
+        break;
+    }
+
+    xiao_audit_emit(req->cmd, path_hash, req->pid, caps, verdict);
+}
+
+void xiao_audit_cap(u32 cmd, u32 target_pid, u32 caps, s32 verdict)
+{
+    xiao_audit_emit(cmd, 0, target_pid, caps, verdict);
+}
+
+int xiao_read_audit(struct xiao_audit_batch *batch, u32 size, u32 *data_len)
+{
+    u32 max_records;
+
+    if (!batch || !data_len || size < sizeof(*batch))
+        return -EINVAL;
+
+    /* The trail is host-wide, so namespaced root is not enough */
+    if (!capable(CAP_AUDIT_READ))
+        return -EPERM;
+
+    max_records = (size - sizeof(*batch)) / sizeof(struct xiao_audit_record);
+
+    batch->count = xiao_ring_drain(&xiao_audit_ring, batch->records, max_records,
+                                   &batch->dropped);
+    *data_len = sizeof(*batch) + batch->count * sizeof(struct xiao_audit_record);
+
+    return 0;
+}
+
+static int xiao_audit_proc_show(struct seq_file *m, void *v)
+{
+    seq_printf(m, "xiao audit bridge\n");
+    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "operations: read_audit\n");
+
+    seq_printf(m, "\n--- Audit Ring ---\n");
+    seq_printf(m, "records per cpu: %u\n", XIAO_AUDIT_RING_SIZE);
+    seq_printf(m, "record size: %zu\n", sizeof(struct xiao_audit_record));
+    seq_printf(m, "pending: %u\n", xiao_ring_pending(&xiao_audit_ring));
+
+    return 0;
+}
+
+static int xiao_audit_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, xiao_audit_proc_show, NULL);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops xiao_audit_proc_fops = {
+    .proc_open = xiao_audit_proc_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+#else
+static const struct file_operations xiao_audit_proc_fops = {
+    .owner = THIS_MODULE,
+    .open = xiao_audit_proc_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+#endif
+
+static struct proc_dir_entry *xiao_audit_proc_entry;
+
+int __init xiao_audit_init(void)
+{
+    int ret;
+
+    ret = xiao_ring_init(&xiao_audit_ring, XIAO_AUDIT_RING_SIZE,
+                         sizeof(struct xiao_audit_record));
+    if (ret) {
+        pr_err("xiao_audit: failed to allocate audit ring\n");
+        return ret;
+    }
+
+    xiao_audit_proc_entry = proc_create("xiao_audit", 0444, NULL, &xiao_audit_proc_fops);
+    if (!xiao_audit_proc_entry) {
+        pr_err("xiao_audit: failed to create proc entry\n");
+        xiao_ring_free(&xiao_audit_ring);
+        return -ENOMEM;
+    }
+
+    WRITE_ONCE(xiao_audit_ready, true);
+    pr_info("xiao_audit: audit subsystem initialized\n");
+    return 0;
+}
+
+void __exit xiao_audit_exit(void)
+{
+    if (xiao_audit_proc_entry)
+        remove_proc_entry("xiao_audit", NULL);
+
+    WRITE_ONCE(xiao_audit_ready, false);
+    xiao_ring_free(&xiao_audit_ring);
+    pr_info("xiao_audit: audit subsystem cleanup complete\n");
+}
@@ -0,0 +1,349 @@
+#include "xiao_syscall.h"
+
+/*
+ * Each subscriber owns a cursor into the broadcast ring, so readers never
+ * consume each other's events. File sessions keep their subscription in
+ * the session and drop it on release; netlink subscribers are keyed by
+ * portid and dropped when their socket closes.
+ */
+struct xiao_event_sub {
+    struct list_head node;
+    u32 portid;
+    unsigned long *cursor;
+};
+
+static DEFINE_MUTEX(xiao_event_lock);
+static struct xiao_bcast_set xiao_event_ring;
+static LIST_HEAD(xiao_event_nl_subs);
+static u32 xiao_event_subscribers;
+static bool xiao_event_registered;
+
+static struct tracepoint *xiao_tp_fork;
+static struct tracepoint *xiao_tp_exec;
+static struct tracepoint *xiao_tp_exit;
+
+struct xiao_tp_lookup {
+    const char *name;
+    struct tracepoint *tp;
+};
+
+static void xiao_tp_match(struct tracepoint *tp, void *priv)
+{
+    struct xiao_tp_lookup *lookup = priv;
+
+    if (!lookup->tp && strcmp(tp->name, lookup->name) == 0)
+        lookup->tp = tp;
+}
+
+struct tracepoint *xiao_find_tracepoint(const char *name)
+{
+    struct xiao_tp_lookup lookup = { .name = name };
+
+    for_each_kernel_tracepoint(xiao_tp_match, &lookup);
+    return lookup.tp;
+}
+
+static void xiao_event_emit(u32 type, struct task_struct *task, u32 ppid, s32 exit_code)
+{
+    struct xiao_proc_event ev;
+
+    ev.timestamp = ktime_get_ns();
+    ev.type = type;
+    ev.pid = task->pid;
+    ev.tgid = task->tgid;
+    ev.ppid = ppid;
+    ev.exit_code = exit_code;
+    ev.cpu = raw_smp_processor_id();
+    memcpy(ev.comm, task->comm, TASK_COMM_LEN);
+    ev.comm[TASK_COMM_LEN - 1] = '\0';
+
+    xiao_bcast_write(&xiao_event_ring, &ev);
+}
+
+static void xiao_event_fork_probe(void *data, struct task_struct *parent,
+                                  struct task_struct *child)
+{
+    xiao_event_emit(XIAO_PROC_EVENT_FORK, child, parent->tgid, 0);
+}
+
+static void xiao_event_exec_probe(void *data, struct task_struct *task,
+                                  pid_t old_pid, struct linux_binprm *bprm)
+{
+    xiao_event_emit(XIAO_PROC_EVENT_EXEC, task, 0, 0);
+}
+
+static XIAO_EXIT_PROBE(xiao_event_exit_probe)
+{
+    xiao_event_emit(XIAO_PROC_EVENT_EXIT, task, 0, task->exit_code);
+}
+
+static int xiao_event_register(void)
+{
+    int ret;
+
+    ret = tracepoint_probe_register(xiao_tp_fork, xiao_event_fork_probe, NULL);
+    if (ret)
+        return ret;
+
+    ret = tracepoint_probe_register(xiao_tp_exec, xiao_event_exec_probe, NULL);
+    if (ret)
+        goto fail_exec;
+
+    ret = tracepoint_probe_register(xiao_tp_exit, xiao_event_exit_probe, NULL);
+    if (ret)
+        goto fail_exit;
+
+    xiao_event_registered = true;
+    return 0;
+
+fail_exit:
+    tracepoint_probe_unregister(xiao_tp_exec, xiao_event_exec_probe, NULL);
+fail_exec:
+    tracepoint_probe_unregister(xiao_tp_fork, xiao_event_fork_probe, NULL);
+    return ret;
+}
+
+static void xiao_event_unregister(void)
+{
+    if (!xiao_event_registered)
+        return;
+
+    tracepoint_probe_unregister(xiao_tp_exit, xiao_event_exit_probe, NULL);
+    tracepoint_probe_unregister(xiao_tp_exec, xiao_event_exec_probe, NULL);
+    tracepoint_probe_unregister(xiao_tp_fork, xiao_event_fork_probe, NULL);
+    tracepoint_synchronize_unregister();
+    xiao_event_registered = false;
+}
+
+/* Caller holds xiao_event_lock */
+static struct xiao_event_sub *xiao_event_find(struct xiao_session *session, u32 portid)
+{
+    struct xiao_event_sub *sub;
+
+    if (session)
+        return session->events;
+
+    list_for_each_entry(sub, &xiao_event_nl_subs, node) {
+        if (sub->portid == portid)
+            return sub;
+    }
+
+    return NULL;
+}
+
+/* Caller holds xiao_event_lock */
+static void xiao_event_drop(struct xiao_session *session, struct xiao_event_sub *sub)
+{
+    if (session)
+        session->events = NULL;
+    else
+        list_del(&sub->node);
+
+    kfree(sub->cursor);
+    kfree(sub);
+
+    if (xiao_event_subscribers > 0 && --xiao_event_subscribers == 0)
+        xiao_event_unregister();
+}
+
+/* session is NULL for netlink callers, which are identified by portid */
+int xiao_proc_events_ctl(struct xiao_session *session, u32 portid, u32 enable)
+{
+    struct xiao_event_sub *sub;
+    int ret = 0;
+
+    if (!xiao_tp_fork || !xiao_tp_exec || !xiao_tp_exit)
+        return -EOPNOTSUPP;
+
+    mutex_lock(&xiao_event_lock);
+
+    sub = xiao_event_find(session, portid);
+
+    if (!enable) {
+        if (sub)
+            xiao_event_drop(session, sub);
+        goto out;
+    }
+
+    if (sub)
+        goto out;
+
+    sub = kzalloc(sizeof(*sub), GFP_KERNEL);
+    if (!sub) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    sub->portid = portid;
+    sub->cursor = xiao_bcast_cursor_alloc(&xiao_event_ring);
+    if (!sub->cursor) {
+        kfree(sub);
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    if (xiao_event_subscribers == 0) {
+        ret = xiao_event_register();
+        if (ret) {
+            kfree(sub->cursor);
+            kfree(sub);
+            goto out;
+        }
+    }
+    xiao_event_subscribers++;
+
+    if (session)
+        session->events = sub;
+    else
+        list_add(&sub->node, &xiao_event_nl_subs);
+
+out:
+    mutex_unlock(&xiao_event_lock);
+    return ret;
+}
+
+int xiao_get_proc_events(struct xiao_session *session, u32 portid,
+                         struct xiao_proc_event_batch *batch, u32 size, u32 *data_len)
+{
+    struct xiao_event_sub *sub;
+    u32 max_events;
+    int ret = 0;
+
+    if (!batch || !data_len || size < sizeof(*batch))
+        return -EINVAL;
+
+    max_events = (size - sizeof(*batch)) / sizeof(struct xiao_proc_event);
+
+    mutex_lock(&xiao_event_lock);
+
+    sub = xiao_event_find(session, portid);
+    if (!sub) {
+        ret = -ENOENT;
+        goto out;
+    }
+
+    batch->count = xiao_bcast_read(&xiao_event_ring, sub->cursor, batch->events, max_events,
+                                   &batch->dropped);
+    *data_len = sizeof(*batch) + batch->count * sizeof(struct xiao_proc_event);
+
+out:
+    mutex_unlock(&xiao_event_lock);
+    return ret;
+}
+
+static int xiao_event_nl_notify(struct notifier_block *nb, unsigned long event, void *ptr)
+{
+    struct netlink_notify *n = ptr;
+    struct xiao_event_sub *sub;
+
+    if (event != NETLINK_URELEASE || n->protocol != NETLINK_USERSOCK)
+        return NOTIFY_DONE;
+
+    mutex_lock(&xiao_event_lock);
+    sub = xiao_event_find(NULL, n->portid);
+    if (sub)
+        xiao_event_drop(NULL, sub);
+    mutex_unlock(&xiao_event_lock);
+
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block xiao_event_nl_notifier = {
+    .notifier_call = xiao_event_nl_notify,
+};
+
+static int xiao_event_proc_show(struct seq_file *m, void *v)
+{
+    seq_printf(m, "xiao process event bridge\n");
+    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "operations: proc_events_ctl, get_proc_events\n");
+
+    seq_printf(m, "\n--- Event Stream ---\n");
+    seq_printf(m, "tracepoints: %s\n",
+               xiao_tp_fork && xiao_tp_exec && xiao_tp_exit ? "available" : "unavailable");
+    seq_printf(m, "subscribers: %u\n", READ_ONCE(xiao_event_subscribers));
+    seq_printf(m, "probes: %s\n", READ_ONCE(xiao_event_registered) ? "attached" : "detached");
+
+    return 0;
+}
+
+static int xiao_event_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, xiao_event_proc_show, NULL);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops xiao_event_proc_fops = {
+    .proc_open = xiao_event_proc_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+#else
+static const struct file_operations xiao_event_proc_fops = {
+    .owner = THIS_MODULE,
+    .open = xiao_event_proc_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+#endif
+
+static struct proc_dir_entry *xiao_event_proc_entry;
+
+int __init xiao_event_init(void)
+{
+    int ret;
+
+    ret = xiao_bcast_init(&xiao_event_ring, XIAO_EVENT_RING_SIZE,
+                          sizeof(struct xiao_proc_event));
+    if (ret) {
+        pr_err("xiao_event: failed to allocate event ring\n");
+        return ret;
+    }
+
+    xiao_tp_fork = xiao_find_tracepoint("sched_process_fork");
+    xiao_tp_exec = xiao_find_tracepoint("sched_process_exec");
+    xiao_tp_exit = xiao_find_tracepoint("sched_process_exit");
+    if (!xiao_tp_fork || !xiao_tp_exec || !xiao_tp_exit)
+        pr_warn("xiao_event: scheduler tracepoints not found, event stream disabled\n");
+
+    xiao_event_proc_entry = proc_create("xiao_events", 0444, NULL, &xiao_event_proc_fops);
+    if (!xiao_event_proc_entry) {
+        pr_err("xiao_event: failed to create proc entry\n");
+        xiao_bcast_free(&xiao_event_ring);
+        return -ENOMEM;
+    }
+
+    ret = netlink_register_notifier(&xiao_event_nl_notifier);
+    if (ret) {
+        pr_err("xiao_event: failed to register netlink notifier\n");
+        remove_proc_entry("xiao_events", NULL);
+        xiao_bcast_free(&xiao_event_ring);
+        return ret;
+    }
+
+    pr_info("xiao_event: process event subsystem initialized\n");
+    return 0;
+}
+
+void __exit xiao_event_exit(void)
+{
+    struct xiao_event_sub *sub, *tmp;
+
+    if (xiao_event_proc_entry)
+        remove_proc_entry("xiao_events", NULL);
+
+    netlink_unregister_notifier(&xiao_event_nl_notifier);
+
+    /* File sessions were released with the bridge entry; only netlink remains */
+    mutex_lock(&xiao_event_lock);
+    list_for_each_entry_safe(sub, tmp, &xiao_event_nl_subs, node)
+        xiao_event_drop(NULL, sub);
+    xiao_event_unregister();
+    xiao_event_subscribers = 0;
+    mutex_unlock(&xiao_event_lock);
+
+    xiao_bcast_free(&xiao_event_ring);
+    pr_info("xiao_event: process event subsystem cleanup complete\n");
+}
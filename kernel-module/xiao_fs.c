@@ -36,7 +36,7 @@ int xiao_read_file(const char __user *path, char __user *buf, size_t count, loff
     if (ret)
         return ret;
 
-    mutex_lock(&xiao_fs_lock);
+    xiao_mutex_lock_traced(&xiao_fs_lock, XIAO_LOCK_FS);
 
     filp = filp_open(path, O_RDONLY, 0);
     if (IS_ERR(filp)) {
@@ -83,7 +83,7 @@ int xiao_write_file(const char __user *path, const char __user *buf, size_t coun
     if (ret)
         return ret;
 
-    mutex_lock(&xiao_fs_lock);
+    xiao_mutex_lock_traced(&xiao_fs_lock, XIAO_LOCK_FS);
 
     filp = filp_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
     if (IS_ERR(filp)) {
@@ -141,7 +141,7 @@ int xiao_list_dir(const char __user *path, char __user *buf, size_t count)
     if (!tmp_buf)
         return -ENOMEM;
 
-    mutex_lock(&xiao_fs_lock);
+    xiao_mutex_lock_traced(&xiao_fs_lock, XIAO_LOCK_FS);
 
     filp = filp_open(path, O_RDONLY | O_DIRECTORY, 0);
     if (IS_ERR(filp)) {
@@ -182,6 +182,141 @@ out:
     return ret;
 }
 
+static ssize_t xiao_kernel_read_fp(struct file *fp, char *buf, size_t size)
+{
+    loff_t pos = 0;
+    ssize_t len = 0;
+    ssize_t n;
+
+    while (len < size - 1) {
+        n = kernel_read(fp, buf + len, size - 1 - len, &pos);
+        if (n < 0) {
+            len = n;
+            goto out;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+    buf[len] = '\0';
+
+out:
+    filp_close(fp, NULL);
+    return len;
+}
+
+ssize_t xiao_kernel_read_file(const char *path, char *buf, size_t size)
+{
+    struct file *fp;
+
+    if (!path || !buf || !size)
+        return -EINVAL;
+
+    fp = filp_open(path, O_RDONLY, 0);
+    if (IS_ERR(fp))
+        return PTR_ERR(fp);
+
+    return xiao_kernel_read_fp(fp, buf, size);
+}
+
+/*
+ * Like xiao_kernel_read_file(), but a relative @path is resolved against
+ * the root of init rather than that of the calling task, so the result
+ * does not depend on the caller's chroot or mount namespace.
+ */
+ssize_t xiao_kernel_read_init_file(const char *path, char *buf, size_t size)
+{
+    struct task_struct *init;
+    struct path root;
+    struct file *fp;
+
+    if (!path || !buf || !size)
+        return -EINVAL;
+
+    rcu_read_lock();
+    init = pid_task(find_pid_ns(1, &init_pid_ns), PIDTYPE_PID);
+    if (init)
+        get_task_struct(init);
+    rcu_read_unlock();
+    if (!init)
+        return -ESRCH;
+
+    task_lock(init);
+    if (!init->fs) {
+        task_unlock(init);
+        put_task_struct(init);
+        return -ESRCH;
+    }
+    get_fs_root(init->fs, &root);
+    task_unlock(init);
+    put_task_struct(init);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0)
+    fp = file_open_root(&root, path, O_RDONLY, 0);
+#else
+    fp = file_open_root(root.dentry, root.mnt, path, O_RDONLY, 0);
+#endif
+    path_put(&root);
+    if (IS_ERR(fp))
+        return PTR_ERR(fp);
+
+    return xiao_kernel_read_fp(fp, buf, size);
+}
+
+struct xiao_dir_collect {
+    struct dir_context ctx;
+    char (*names)[XIAO_DEV_NAME_LEN];
+    u32 max;
+    u32 count;
+};
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+static bool xiao_dir_collect_actor(struct dir_context *ctx, const char *name, int namlen,
+                                   loff_t offset, u64 ino, unsigned int d_type)
+#else
+static int xiao_dir_collect_actor(struct dir_context *ctx, const char *name, int namlen,
+                                  loff_t offset, u64 ino, unsigned int d_type)
+#endif
+{
+    struct xiao_dir_collect *dc = container_of(ctx, struct xiao_dir_collect, ctx);
+
+    if (name[0] != '.' && namlen < XIAO_DEV_NAME_LEN && dc->count < dc->max) {
+        memcpy(dc->names[dc->count], name, namlen);
+        dc->names[dc->count][namlen] = '\0';
+        dc->count++;
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+    return dc->count < dc->max;
+#else
+    return dc->count < dc->max ? 0 : -ENOSPC;
+#endif
+}
+
+int xiao_kernel_list_names(const char *path, char (*names)[XIAO_DEV_NAME_LEN], u32 max, u32 *count)
+{
+    struct xiao_dir_collect dc = {
+        .ctx.actor = xiao_dir_collect_actor,
+        .names = names,
+        .max = max,
+    };
+    struct file *fp;
+    int ret;
+
+    if (!path || !names || !count)
+        return -EINVAL;
+
+    fp = filp_open(path, O_RDONLY | O_DIRECTORY, 0);
+    if (IS_ERR(fp))
+        return PTR_ERR(fp);
+
+    ret = iterate_dir(fp, &dc.ctx);
+    filp_close(fp, NULL);
+
+    *count = dc.count;
+    return dc.count ? 0 : ret;
+}
+
 static int xiao_fs_proc_show(struct seq_file *m, void *v)
 {
     seq_printf(m, "xiao filesystem bridge\n");
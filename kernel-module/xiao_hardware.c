@@ -1,198 +1,886 @@
 #include "xiao_syscall.h"
 
-static DEFINE_MUTEX(xiao_hw_lock);
+/*
+ * Everything reported by GET_HW_INFO except the online CPU count is fixed
+ * once the machine has booted, so it is collected once at module init.
+ */
+static struct xiao_hw_info xiao_hw_snapshot __ro_after_init;
 
-int xiao_get_hw_info(struct xiao_hw_info __user *info)
+static void __init xiao_hw_copy_dmi(char *dst, size_t size, int field)
+{
+    const char *val = dmi_get_system_info(field);
+
+    if (val)
+        strscpy(dst, val, size);
+}
+
+static void __init xiao_hw_build_snapshot(struct xiao_hw_info *hw)
+{
+    memset(hw, 0, sizeof(*hw));
+
+#ifdef CONFIG_X86
+    strscpy(hw->cpu_vendor, boot_cpu_data.x86_vendor_id, sizeof(hw->cpu_vendor));
+    strscpy(hw->cpu_model, boot_cpu_data.x86_model_id, sizeof(hw->cpu_model));
+    strim(hw->cpu_model);
+    hw->cpu_family = boot_cpu_data.x86;
+    hw->cpu_model_id = boot_cpu_data.x86_model;
+    hw->cpu_stepping = boot_cpu_data.x86_stepping;
+#else
+    strscpy(hw->cpu_model, init_utsname()->machine, sizeof(hw->cpu_model));
+#endif
+
+    hw->mem_total = (u64)totalram_pages() << PAGE_SHIFT;
+    hw->bogomips = loops_per_jiffy / (500000 / HZ);
+
+    xiao_hw_copy_dmi(hw->board_name, sizeof(hw->board_name), DMI_BOARD_NAME);
+    xiao_hw_copy_dmi(hw->bios_version, sizeof(hw->bios_version), DMI_BIOS_VERSION);
+    xiao_hw_copy_dmi(hw->bios_date, sizeof(hw->bios_date), DMI_BIOS_DATE);
+
+    /* System identity prefers DMI and falls back to the boot CPU */
+    strscpy(hw->vendor, hw->cpu_vendor, sizeof(hw->vendor));
+    strscpy(hw->model, hw->cpu_model, sizeof(hw->model));
+    xiao_hw_copy_dmi(hw->vendor, sizeof(hw->vendor), DMI_SYS_VENDOR);
+    xiao_hw_copy_dmi(hw->model, sizeof(hw->model), DMI_PRODUCT_NAME);
+}
+
+int xiao_get_hw_info(struct xiao_hw_info *info)
 {
-    struct xiao_hw_info hwinfo;
-    struct file *fp;
-    char line[256];
-    char *p;
-    int ret;
 
     if (!info)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_HW_INFO);
-    if (ret)
-        return ret;
+    memcpy(info, &xiao_hw_snapshot, sizeof(*info));
+    info->num_cpus = num_online_cpus();
 
-    memset(&hwinfo, 0, sizeof(hwinfo));
-
-    fp = filp_open("/proc/cpuinfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        hwinfo.num_cpus = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "vendor_id", 9) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    while (*p == ' ') p++;
-                    strncpy(hwinfo.vendor, p, sizeof(hwinfo.vendor) - 1);
-                    hwinfo.vendor[strcspn(hwinfo.vendor, "\n")] = 0;
-                }
-            }
-            if (strncmp(line, "model name", 10) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    while (*p == ' ') p++;
-                    strncpy(hwinfo.model, p, sizeof(hwinfo.model) - 1);
-                    hwinfo.model[strcspn(hwinfo.model, "\n")] = 0;
-                }
-            }
-            if (strncmp(line, "processor", 9) == 0) {
-                hwinfo.num_cpus++;
-            }
-            if (strncmp(line, "bogomips", 8) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    kstrtou64(p, 10, &hwinfo.bogomips);
-                }
-            }
-        }
-        filp_close(fp, NULL);
-    }
-
-    fp = filp_open("/proc/meminfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "MemTotal:", 9) == 0) {
-                p = line + 9;
-                kstrtou64(p, 10, &hwinfo.mem_total);
-                hwinfo.mem_total *= 1024;
-            }
-        }
-        filp_close(fp, NULL);
+    return 0;
+}
+
+struct xiao_cpu_caches {
+    bool loaded;
+    u32 count;
+    struct xiao_cache_desc caches[XIAO_CPU_MAX_CACHES];
+};
+
+/*
+ * Cache geometry is read from sysfs the first time a CPU is queried while
+ * online, so CPUs hotplugged after load are picked up too.
+ */
+static DEFINE_MUTEX(xiao_hw_cache_lock);
+static struct xiao_cpu_caches *xiao_hw_caches;
+static u64 xiao_hw_isa_flags __ro_after_init;
+
+static u64 __init xiao_hw_isa_detect(void)
+{
+    u64 flags = 0;
+
+#ifdef CONFIG_X86
+    if (boot_cpu_has(X86_FEATURE_XMM2))
+        flags |= XIAO_ISA_SSE2;
+    if (boot_cpu_has(X86_FEATURE_XMM4_2))
+        flags |= XIAO_ISA_SSE4_2;
+    if (boot_cpu_has(X86_FEATURE_AVX))
+        flags |= XIAO_ISA_AVX;
+    if (boot_cpu_has(X86_FEATURE_AVX2))
+        flags |= XIAO_ISA_AVX2;
+    if (boot_cpu_has(X86_FEATURE_AVX512F))
+        flags |= XIAO_ISA_AVX512F;
+    if (boot_cpu_has(X86_FEATURE_AVX512BW))
+        flags |= XIAO_ISA_AVX512BW;
+    if (boot_cpu_has(X86_FEATURE_FMA))
+        flags |= XIAO_ISA_FMA;
+    if (boot_cpu_has(X86_FEATURE_BMI2))
+        flags |= XIAO_ISA_BMI2;
+    if (boot_cpu_has(X86_FEATURE_AES))
+        flags |= XIAO_ISA_AES;
+    if (boot_cpu_has(X86_FEATURE_SHA_NI))
+        flags |= XIAO_ISA_SHA;
+#endif
+
+#ifdef CONFIG_ARM64
+    if (cpu_have_named_feature(ASIMD))
+        flags |= XIAO_ISA_NEON;
+    if (cpu_have_named_feature(ASIMDDP))
+        flags |= XIAO_ISA_DOTPROD;
+    if (cpu_have_named_feature(AES))
+        flags |= XIAO_ISA_AES;
+    if (cpu_have_named_feature(SHA2))
+        flags |= XIAO_ISA_SHA;
+    if (cpu_have_named_feature(CRC32))
+        flags |= XIAO_ISA_CRC32;
+    if (cpu_have_named_feature(ATOMICS))
+        flags |= XIAO_ISA_ATOMICS;
+    if (cpu_have_named_feature(SVE))
+        flags |= XIAO_ISA_SVE;
+    if (cpu_have_named_feature(SVE2))
+        flags |= XIAO_ISA_SVE2;
+#endif
+
+    return flags;
+}
+
+static int xiao_hw_read_sysfs(const char *path, char *buf, size_t size)
+{
+    ssize_t len;
+
+    len = xiao_kernel_read_file(path, buf, size);
+    if (len <= 0)
+        return len ? len : -ENODATA;
+
+    strim(buf);
+    return 0;
+}
+
+static int xiao_hw_read_attr(int cpu, int index, const char *attr, char *buf, size_t size)
+{
+    char path[96];
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/%s",
+             cpu, index, attr);
+
+    return xiao_hw_read_sysfs(path, buf, size);
+}
+
+static u32 xiao_hw_read_attr_u32(int cpu, int index, const char *attr)
+{
+    char buf[32];
+    u32 val = 0;
+
+    if (xiao_hw_read_attr(cpu, index, attr, buf, sizeof(buf)) == 0)
+        kstrtou32(buf, 10, &val);
+
+    return val;
+}
+
+static void xiao_hw_load_caches(int cpu, struct xiao_cpu_caches *ci)
+{
+    struct xiao_cache_desc *desc;
+    cpumask_var_t shared;
+    char buf[256];
+    int index;
+
+    if (!zalloc_cpumask_var(&shared, GFP_KERNEL))
+        return;
+
+    ci->count = 0;
+
+    for (index = 0; index < XIAO_CPU_MAX_CACHES; index++) {
+        if (xiao_hw_read_attr(cpu, index, "type", buf, sizeof(buf)))
+            break;
+
+        desc = &ci->caches[ci->count++];
+        if (strcmp(buf, "Data") == 0)
+            desc->type = XIAO_CACHE_DATA;
+        else if (strcmp(buf, "Instruction") == 0)
+            desc->type = XIAO_CACHE_INST;
+        else
+            desc->type = XIAO_CACHE_UNIFIED;
+
+        desc->level = xiao_hw_read_attr_u32(cpu, index, "level");
+        desc->ways = xiao_hw_read_attr_u32(cpu, index, "ways_of_associativity");
+        desc->line_size = xiao_hw_read_attr_u32(cpu, index, "coherency_line_size");
+
+        if (xiao_hw_read_attr(cpu, index, "size", buf, sizeof(buf)) == 0)
+            desc->size = memparse(buf, NULL);
+
+        if (xiao_hw_read_attr(cpu, index, "shared_cpu_list", buf, sizeof(buf)) == 0 &&
+            cpulist_parse(buf, shared) == 0)
+            desc->shared_cpus = cpumask_weight(shared);
     }
 
-    fp = filp_open("/sys/class/dmi/id/sys_vendor", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, hwinfo.vendor, sizeof(hwinfo.vendor) - 1, &pos);
-        if (len > 0) {
-            hwinfo.vendor[len] = '\0';
-            hwinfo.vendor[strcspn(hwinfo.vendor, "\n")] = 0;
-        }
-        filp_close(fp, NULL);
+    free_cpumask_var(shared);
+    ci->loaded = true;
+}
+
+static void xiao_hw_fill_topology(int cpu, struct xiao_cpu_topology *topo)
+{
+    memset(topo, 0, sizeof(*topo));
+    topo->cpu = cpu;
+    topo->online = cpu_online(cpu);
+    topo->package_id = topology_physical_package_id(cpu);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
+    topo->die_id = topology_die_id(cpu);
+#endif
+    topo->core_id = topology_core_id(cpu);
+    topo->node = cpu_to_node(cpu);
+    topo->smt_siblings = cpumask_weight(topology_sibling_cpumask(cpu));
+    topo->core_siblings = cpumask_weight(topology_core_cpumask(cpu));
+
+    if (xiao_hw_caches) {
+        mutex_lock(&xiao_hw_cache_lock);
+        /* The cache directory only exists while the CPU is online */
+        if (!xiao_hw_caches[cpu].loaded && topo->online)
+            xiao_hw_load_caches(cpu, &xiao_hw_caches[cpu]);
+        topo->nr_caches = xiao_hw_caches[cpu].count;
+        memcpy(topo->caches, xiao_hw_caches[cpu].caches, sizeof(topo->caches));
+        mutex_unlock(&xiao_hw_cache_lock);
     }
+}
 
-    fp = filp_open("/sys/class/dmi/id/product_name", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, hwinfo.model, sizeof(hwinfo.model) - 1, &pos);
-        if (len > 0) {
-            hwinfo.model[len] = '\0';
-            hwinfo.model[strcspn(hwinfo.model, "\n")] = 0;
-        }
-        filp_close(fp, NULL);
+int xiao_get_cpu_topology(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_topology_header *hdr = buf;
+    struct xiao_cpu_topology *out = (struct xiao_cpu_topology *)(hdr + 1);
+    u32 max_out, count = 0, idx = 0;
+    int cpu;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    for_each_present_cpu(cpu) {
+        if (idx++ < query->offset || count >= max_out)
+            continue;
+
+        xiao_hw_fill_topology(cpu, &out[count++]);
     }
 
-    fp = filp_open("/sys/class/dmi/id/bios_version", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, hwinfo.bios_version, sizeof(hwinfo.bios_version) - 1, &pos);
-        if (len > 0) {
-            hwinfo.bios_version[len] = '\0';
-            hwinfo.bios_version[strcspn(hwinfo.bios_version, "\n")] = 0;
-        }
-        filp_close(fp, NULL);
+    hdr->total = idx;
+    hdr->count = count;
+    hdr->isa_flags = xiao_hw_isa_flags;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_cpu_topology);
+
+    return 0;
+}
+
+/* dev->driver is only stable under the device lock; probe and unbind take it */
+static inline void xiao_hw_driver_name(struct device *dev, char *buf, size_t len)
+{
+    device_lock(dev);
+    if (dev->driver)
+        strscpy(buf, dev->driver->name, len);
+    device_unlock(dev);
+}
+
+#if IS_ENABLED(CONFIG_PCI)
+int xiao_get_pci_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_pci_device *out = (struct xiao_pci_device *)(hdr + 1);
+    struct xiao_pci_device *info;
+    struct pci_dev *pdev = NULL;
+    u32 max_out, count = 0, idx = 0;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    for_each_pci_dev(pdev) {
+        if (idx++ < query->offset || count >= max_out)
+            continue;
+
+        info = &out[count++];
+        memset(info, 0, sizeof(*info));
+        info->domain = pci_domain_nr(pdev->bus);
+        info->bus = pdev->bus->number;
+        info->devfn = pdev->devfn;
+        info->vendor = pdev->vendor;
+        info->device = pdev->device;
+        info->subsystem_vendor = pdev->subsystem_vendor;
+        info->subsystem_device = pdev->subsystem_device;
+        info->revision = pdev->revision;
+        info->class = pdev->class;
+
+        xiao_hw_driver_name(&pdev->dev, info->driver, sizeof(info->driver));
     }
 
-    if (copy_to_user(info, &hwinfo, sizeof(hwinfo)))
-        return -EFAULT;
+    hdr->total = idx;
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_pci_device);
 
     return 0;
 }
+#else
+int xiao_get_pci_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    return -EOPNOTSUPP;
+}
+#endif
 
-static int xiao_hw_proc_show(struct seq_file *m, void *v)
+#if IS_ENABLED(CONFIG_USB)
+struct xiao_usb_walk {
+    const struct xiao_page_query *query;
+    struct xiao_usb_device *out;
+    u32 max_out;
+    u32 count;
+    u32 idx;
+};
+
+static int xiao_usb_visit(struct usb_device *udev, void *data)
 {
-    struct file *fp;
-    char line[256];
-    char *p;
+    struct xiao_usb_walk *walk = data;
+    struct xiao_usb_device *info;
 
-    seq_printf(m, "xiao hardware info bridge\n");
-    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
-    seq_printf(m, "operations: get_hw_info\n");
+    if (walk->idx++ < walk->query->offset || walk->count >= walk->max_out)
+        return 0;
 
-    seq_printf(m, "\n--- CPU Information ---\n");
+    info = &walk->out[walk->count++];
+    memset(info, 0, sizeof(*info));
+    info->vendor = le16_to_cpu(udev->descriptor.idVendor);
+    info->product = le16_to_cpu(udev->descriptor.idProduct);
+    info->bcd_device = le16_to_cpu(udev->descriptor.bcdDevice);
+    info->busnum = udev->bus->busnum;
+    info->devnum = udev->devnum;
+    info->dev_class = udev->descriptor.bDeviceClass;
+    info->dev_subclass = udev->descriptor.bDeviceSubClass;
+    info->dev_protocol = udev->descriptor.bDeviceProtocol;
+    info->speed = udev->speed;
+
+    if (udev->manufacturer)
+        strscpy(info->manufacturer, udev->manufacturer, sizeof(info->manufacturer));
+    if (udev->product)
+        strscpy(info->name, udev->product, sizeof(info->name));
+
+    xiao_hw_driver_name(&udev->dev, info->driver, sizeof(info->driver));
+
+    return 0;
+}
+
+int xiao_get_usb_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_usb_walk walk = { .query = query };
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    walk.out = (struct xiao_usb_device *)(hdr + 1);
+    walk.max_out = (size - sizeof(*hdr)) / sizeof(*walk.out);
+    if (query->max_count && query->max_count < walk.max_out)
+        walk.max_out = query->max_count;
 
-    fp = filp_open("/proc/cpuinfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "vendor_id", 9) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    seq_printf(m, "Vendor: %s", p);
-                }
-            }
-            if (strncmp(line, "model name", 10) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    seq_printf(m, "Model: %s", p);
-                }
-            }
-            if (strncmp(line, "processor", 9) == 0) {
-                seq_printf(m, "Processor: detected\n");
-            }
+    usb_for_each_dev(&walk, xiao_usb_visit);
+
+    hdr->total = walk.idx;
+    hdr->count = walk.count;
+    *data_len = sizeof(*hdr) + walk.count * sizeof(struct xiao_usb_device);
+
+    return 0;
+}
+#else
+int xiao_get_usb_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    return -EOPNOTSUPP;
+}
+#endif
+
+static u32 xiao_block_attr_u32(const char *disk, const char *attr)
+{
+    char path[96];
+    char val[32];
+    u32 ret = 0;
+
+    snprintf(path, sizeof(path), "/sys/block/%s/%s", disk, attr);
+    if (xiao_hw_read_sysfs(path, val, sizeof(val)) == 0)
+        kstrtou32(val, 10, &ret);
+
+    return ret;
+}
+
+static void xiao_block_fill(const char *disk, struct xiao_block_device *info)
+{
+    char path[96];
+    char val[128];
+    char *start, *end;
+    u64 sectors = 0;
+
+    memset(info, 0, sizeof(*info));
+    strscpy(info->name, disk, sizeof(info->name));
+
+    snprintf(path, sizeof(path), "/sys/block/%s/size", disk);
+    if (xiao_hw_read_sysfs(path, val, sizeof(val)) == 0 && kstrtou64(val, 10, &sectors) == 0)
+        info->capacity = sectors << SECTOR_SHIFT;
+
+    info->logical_block_size = xiao_block_attr_u32(disk, "queue/logical_block_size");
+    info->physical_block_size = xiao_block_attr_u32(disk, "queue/physical_block_size");
+    info->nr_requests = xiao_block_attr_u32(disk, "queue/nr_requests");
+    info->rotational = xiao_block_attr_u32(disk, "queue/rotational");
+    info->removable = xiao_block_attr_u32(disk, "removable");
+    info->read_only = xiao_block_attr_u32(disk, "ro");
+
+    /* The active scheduler is the bracketed entry, e.g. "mq-deadline [none]" */
+    snprintf(path, sizeof(path), "/sys/block/%s/queue/scheduler", disk);
+    if (xiao_hw_read_sysfs(path, val, sizeof(val)) == 0) {
+        start = strchr(val, '[');
+        end = start ? strchr(start, ']') : NULL;
+        if (start && end) {
+            *end = '\0';
+            start++;
+        } else {
+            start = val;
         }
-        filp_close(fp, NULL);
+        strscpy(info->scheduler, start, sizeof(info->scheduler));
     }
 
-    seq_printf(m, "\n--- Memory Information ---\n");
+    snprintf(path, sizeof(path), "/sys/block/%s/device/model", disk);
+    if (xiao_hw_read_sysfs(path, val, sizeof(val)) == 0)
+        strscpy(info->model, val, sizeof(info->model));
+}
 
-    fp = filp_open("/proc/meminfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "MemTotal:", 9) == 0) {
-                seq_printf(m, "%s", line);
-            }
-        }
-        filp_close(fp, NULL);
+int xiao_get_block_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_block_device *out = (struct xiao_block_device *)(hdr + 1);
+    char (*names)[XIAO_DEV_NAME_LEN];
+    u32 max_out, nr = 0, count = 0, i;
+    int ret;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    names = kcalloc(XIAO_BLOCK_MAX_DEVS, sizeof(*names), GFP_KERNEL);
+    if (!names)
+        return -ENOMEM;
+
+    ret = xiao_kernel_list_names("/sys/block", names, XIAO_BLOCK_MAX_DEVS, &nr);
+    if (ret) {
+        kfree(names);
+        return ret;
     }
 
-    seq_printf(m, "\n--- DMI Information ---\n");
+    for (i = query->offset; i < nr && count < max_out; i++)
+        xiao_block_fill(names[i], &out[count++]);
 
-    fp = filp_open("/sys/class/dmi/id/sys_vendor", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, line, sizeof(line) - 1, &pos);
-        if (len > 0) {
-            line[len] = '\0';
-            seq_printf(m, "System Vendor: %s", line);
-        }
-        filp_close(fp, NULL);
+    kfree(names);
+
+    hdr->total = nr;
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_block_device);
+
+    return 0;
+}
+
+/*
+ * Disk statistics come from /sys/block/<disk>/stat, which is the kernel's
+ * part_stat formatted per disk. The sampler keeps the previous counters
+ * for each disk and derives rates from the delta between ticks. The set of
+ * tracked disks is rebuilt every XIAO_DISK_RESCAN_MS, skipping loop, ram
+ * and empty devices, so a tick only reads the stat file of each real disk.
+ */
+struct xiao_disk_counters {
+    u64 reads;
+    u64 read_sectors;
+    u64 read_ticks;
+    u64 writes;
+    u64 write_sectors;
+    u64 write_ticks;
+    u64 io_ticks;
+    u32 in_flight;
+};
+
+struct xiao_disk_rate_state {
+    char name[XIAO_DEV_NAME_LEN];
+    struct xiao_disk_counters last;
+    u64 read_bps;
+    u64 write_bps;
+    u32 read_iops;
+    u32 write_iops;
+    u32 read_lat_us;
+    u32 write_lat_us;
+    u32 util_permille;
+};
+
+static DEFINE_SPINLOCK(xiao_disk_lock);
+static struct xiao_disk_rate_state xiao_disk_rates[XIAO_DISK_MAX];
+static u32 xiao_disk_nr;
+static u64 xiao_disk_ts;
+
+/* Sampler-private state; only xiao_disk_sample() touches these */
+static char xiao_disk_scan[XIAO_BLOCK_MAX_DEVS][XIAO_DEV_NAME_LEN];
+static char xiao_disk_tracked[XIAO_DISK_MAX][XIAO_DEV_NAME_LEN];
+static struct xiao_disk_rate_state xiao_disk_next[XIAO_DISK_MAX];
+static u32 xiao_disk_nr_tracked;
+static u64 xiao_disk_scan_ts;
+
+static int xiao_disk_read_stat(const char *disk, struct xiao_disk_counters *c)
+{
+    char path[96];
+    char buf[256];
+    int ret;
+
+    snprintf(path, sizeof(path), "/sys/block/%s/stat", disk);
+    ret = xiao_hw_read_sysfs(path, buf, sizeof(buf));
+    if (ret)
+        return ret;
+
+    if (sscanf(buf, "%llu %*u %llu %llu %llu %*u %llu %llu %u %llu",
+               &c->reads, &c->read_sectors, &c->read_ticks,
+               &c->writes, &c->write_sectors, &c->write_ticks,
+               &c->in_flight, &c->io_ticks) != 8)
+        return -EINVAL;
+
+    return 0;
+}
+
+static u64 xiao_disk_delta(u64 now, u64 last)
+{
+    return now > last ? now - last : 0;
+}
+
+static u64 xiao_disk_per_sec(u64 delta, u64 elapsed_ns)
+{
+    return elapsed_ns ? div64_u64(delta * NSEC_PER_SEC, elapsed_ns) : 0;
+}
+
+static void xiao_disk_update(struct xiao_disk_rate_state *st, const struct xiao_disk_counters *cur,
+                             const struct xiao_disk_counters *last, u64 elapsed)
+{
+    u64 reads = xiao_disk_delta(cur->reads, last->reads);
+    u64 writes = xiao_disk_delta(cur->writes, last->writes);
+    u64 busy_ns = xiao_disk_delta(cur->io_ticks, last->io_ticks) * NSEC_PER_MSEC;
+
+    st->read_iops = xiao_disk_per_sec(reads, elapsed);
+    st->write_iops = xiao_disk_per_sec(writes, elapsed);
+    st->read_bps = xiao_disk_per_sec(xiao_disk_delta(cur->read_sectors, last->read_sectors)
+                                     << SECTOR_SHIFT, elapsed);
+    st->write_bps = xiao_disk_per_sec(xiao_disk_delta(cur->write_sectors, last->write_sectors)
+                                      << SECTOR_SHIFT, elapsed);
+    st->read_lat_us = reads ?
+        div64_u64(xiao_disk_delta(cur->read_ticks, last->read_ticks) * USEC_PER_MSEC, reads) : 0;
+    st->write_lat_us = writes ?
+        div64_u64(xiao_disk_delta(cur->write_ticks, last->write_ticks) * USEC_PER_MSEC, writes) : 0;
+    st->util_permille = min_t(u64, elapsed ? div64_u64(busy_ns * 1000, elapsed) : 0, 1000);
+}
+
+static const struct xiao_disk_rate_state *xiao_disk_find(const char *name)
+{
+    u32 i;
+
+    for (i = 0; i < xiao_disk_nr; i++) {
+        if (strcmp(xiao_disk_rates[i].name, name) == 0)
+            return &xiao_disk_rates[i];
+    }
+
+    return NULL;
+}
+
+static bool xiao_disk_trackable(const char *disk)
+{
+    char path[96];
+    char val[32];
+    u64 sectors;
+
+    if (strncmp(disk, "loop", 4) == 0 || strncmp(disk, "ram", 3) == 0 ||
+        strncmp(disk, "zram", 4) == 0)
+        return false;
+
+    snprintf(path, sizeof(path), "/sys/block/%s/size", disk);
+    if (xiao_hw_read_sysfs(path, val, sizeof(val)) || kstrtou64(val, 10, &sectors))
+        return false;
+
+    return sectors != 0;
+}
+
+static void xiao_disk_rescan(void)
+{
+    u32 nr = 0, n = 0, i;
+
+    if (xiao_kernel_list_names("/sys/block", xiao_disk_scan, XIAO_BLOCK_MAX_DEVS, &nr))
+        return;
+
+    for (i = 0; i < nr && n < XIAO_DISK_MAX; i++) {
+        if (xiao_disk_trackable(xiao_disk_scan[i]))
+            strscpy(xiao_disk_tracked[n++], xiao_disk_scan[i], XIAO_DEV_NAME_LEN);
+    }
+
+    xiao_disk_nr_tracked = n;
+}
+
+/* Called from the sampler work only, so the table has a single writer */
+void xiao_disk_sample(u64 now_ns)
+{
+    struct xiao_disk_rate_state *next = xiao_disk_next;
+    const struct xiao_disk_rate_state *prev;
+    struct xiao_disk_counters cur;
+    u64 elapsed;
+    u32 n = 0, i;
+
+    if (!xiao_disk_scan_ts || now_ns - xiao_disk_scan_ts >= XIAO_DISK_RESCAN_MS * NSEC_PER_MSEC) {
+        xiao_disk_rescan();
+        xiao_disk_scan_ts = now_ns;
+    }
+
+    elapsed = xiao_disk_ts ? now_ns - xiao_disk_ts : 0;
+
+    for (i = 0; i < xiao_disk_nr_tracked; i++) {
+        if (xiao_disk_read_stat(xiao_disk_tracked[i], &cur))
+            continue;
+
+        memset(&next[n], 0, sizeof(next[n]));
+        strscpy(next[n].name, xiao_disk_tracked[i], sizeof(next[n].name));
+        next[n].last = cur;
+
+        prev = xiao_disk_find(xiao_disk_tracked[i]);
+        if (prev && elapsed)
+            xiao_disk_update(&next[n], &cur, &prev->last, elapsed);
+        n++;
+    }
+
+    spin_lock(&xiao_disk_lock);
+    memcpy(xiao_disk_rates, next, n * sizeof(*next));
+    xiao_disk_nr = n;
+    xiao_disk_ts = now_ns;
+    spin_unlock(&xiao_disk_lock);
+}
+
+int xiao_get_disk_stats(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_disk_stat *out = (struct xiao_disk_stat *)(hdr + 1);
+    const struct xiao_disk_rate_state *st;
+    struct xiao_disk_counters cur;
+    struct xiao_disk_stat *info;
+    char (*names)[XIAO_DEV_NAME_LEN];
+    u32 max_out, nr = 0, count = 0, i;
+    int ret;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    names = kcalloc(XIAO_BLOCK_MAX_DEVS, sizeof(*names), GFP_KERNEL);
+    if (!names)
+        return -ENOMEM;
+
+    ret = xiao_kernel_list_names("/sys/block", names, XIAO_BLOCK_MAX_DEVS, &nr);
+    if (ret) {
+        kfree(names);
+        return ret;
     }
 
-    fp = filp_open("/sys/class/dmi/id/product_name", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, line, sizeof(line) - 1, &pos);
-        if (len > 0) {
-            line[len] = '\0';
-            seq_printf(m, "Product Name: %s", line);
+    for (i = query->offset; i < nr && count < max_out; i++) {
+        if (xiao_disk_read_stat(names[i], &cur))
+            memset(&cur, 0, sizeof(cur));
+
+        info = &out[count++];
+        memset(info, 0, sizeof(*info));
+        strscpy(info->name, names[i], sizeof(info->name));
+        info->reads = cur.reads;
+        info->read_sectors = cur.read_sectors;
+        info->read_ticks_ms = cur.read_ticks;
+        info->writes = cur.writes;
+        info->write_sectors = cur.write_sectors;
+        info->write_ticks_ms = cur.write_ticks;
+        info->io_ticks_ms = cur.io_ticks;
+        info->in_flight = cur.in_flight;
+
+        spin_lock(&xiao_disk_lock);
+        st = xiao_disk_find(names[i]);
+        if (st) {
+            info->read_iops = st->read_iops;
+            info->write_iops = st->write_iops;
+            info->read_bps = st->read_bps;
+            info->write_bps = st->write_bps;
+            info->read_lat_us = st->read_lat_us;
+            info->write_lat_us = st->write_lat_us;
+            info->util_permille = st->util_permille;
         }
-        filp_close(fp, NULL);
+        spin_unlock(&xiao_disk_lock);
     }
 
-    fp = filp_open("/sys/class/dmi/id/bios_version", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        int len = kernel_read(fp, line, sizeof(line) - 1, &pos);
-        if (len > 0) {
-            line[len] = '\0';
-            seq_printf(m, "BIOS Version: %s", line);
+    kfree(names);
+
+    hdr->total = nr;
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_disk_stat);
+
+    return 0;
+}
+
+static u32 xiao_thermal_trip_type(const char *type)
+{
+    if (strcmp(type, "critical") == 0)
+        return XIAO_TRIP_CRITICAL;
+    if (strcmp(type, "hot") == 0)
+        return XIAO_TRIP_HOT;
+    if (strcmp(type, "passive") == 0)
+        return XIAO_TRIP_PASSIVE;
+    return XIAO_TRIP_ACTIVE;
+}
+
+static int xiao_thermal_read_s32(const char *zone, const char *attr, s32 *val)
+{
+    char path[96];
+    char buf[32];
+    int ret;
+
+    snprintf(path, sizeof(path), "/sys/class/thermal/%s/%s", zone, attr);
+    ret = xiao_hw_read_sysfs(path, buf, sizeof(buf));
+    if (ret)
+        return ret;
+
+    return kstrtos32(buf, 10, val);
+}
+
+static void xiao_thermal_fill_zone(const char *zone, struct xiao_thermal_zone *tz)
+{
+    char path[96];
+    char attr[32];
+    char buf[32];
+    u32 i;
+
+    memset(tz, 0, sizeof(*tz));
+    if (kstrtou32(zone + strlen("thermal_zone"), 10, &tz->id))
+        tz->id = U32_MAX;
+
+    snprintf(path, sizeof(path), "/sys/class/thermal/%s/type", zone);
+    if (xiao_hw_read_sysfs(path, buf, sizeof(buf)) == 0)
+        strscpy(tz->type, buf, sizeof(tz->type));
+
+    if (xiao_thermal_read_s32(zone, "temp", &tz->temp))
+        tz->temp = XIAO_THERMAL_INVALID;
+
+    for (i = 0; i < XIAO_THERMAL_MAX_TRIPS; i++) {
+        snprintf(attr, sizeof(attr), "trip_point_%u_temp", i);
+        if (xiao_thermal_read_s32(zone, attr, &tz->trips[i].temp))
+            break;
+
+        snprintf(path, sizeof(path), "/sys/class/thermal/%s/trip_point_%u_type", zone, i);
+        if (xiao_hw_read_sysfs(path, buf, sizeof(buf)) == 0)
+            tz->trips[i].type = xiao_thermal_trip_type(buf);
+        tz->nr_trips++;
+    }
+}
+
+static bool xiao_cpufreq_fill(int cpu, struct xiao_cpu_freq *cf)
+{
+    struct cpufreq_policy *policy;
+
+    policy = cpufreq_cpu_get(cpu);
+    if (!policy)
+        return false;
+
+    memset(cf, 0, sizeof(*cf));
+    cf->cpu = cpu;
+    cf->cur_khz = cpufreq_quick_get(cpu);
+
+    /* The governor can be switched under us without the policy rwsem */
+    down_read(&policy->rwsem);
+    cf->min_khz = policy->min;
+    cf->max_khz = policy->max;
+    cf->hw_min_khz = policy->cpuinfo.min_freq;
+    cf->hw_max_khz = policy->cpuinfo.max_freq;
+
+    /* setpolicy drivers such as intel_pstate have no governor object */
+    if (policy->governor)
+        strscpy(cf->governor, policy->governor->name, sizeof(cf->governor));
+    else if (policy->policy == CPUFREQ_POLICY_PERFORMANCE)
+        strscpy(cf->governor, "performance", sizeof(cf->governor));
+    else if (policy->policy == CPUFREQ_POLICY_POWERSAVE)
+        strscpy(cf->governor, "powersave", sizeof(cf->governor));
+    up_read(&policy->rwsem);
+
+    cpufreq_cpu_put(policy);
+    return true;
+}
+
+/*
+ * Zones and CPUs are paged independently: zones fill the reply first, up to
+ * zone_max, and CPU policies use whatever space is left, up to cpu_max.
+ */
+int xiao_get_thermal(const struct xiao_thermal_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_thermal_header *hdr = buf;
+    struct xiao_thermal_zone *zones = (struct xiao_thermal_zone *)(hdr + 1);
+    struct xiao_cpu_freq *cpus;
+    char (*names)[XIAO_DEV_NAME_LEN];
+    u32 nr = 0, i, max_zones, max_cpus, idx = 0;
+    int cpu;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    memset(hdr, 0, sizeof(*hdr));
+
+    max_zones = (size - sizeof(*hdr)) / sizeof(*zones);
+    if (query->zone_max && query->zone_max < max_zones)
+        max_zones = query->zone_max;
+
+    /* The thermal class also lists cooling devices, hence the larger bound */
+    names = kvcalloc(XIAO_THERMAL_MAX_ENTRIES, sizeof(*names), GFP_KERNEL);
+    if (!names)
+        return -ENOMEM;
+
+    /* No thermal class means no sensors, which is reported as zero zones */
+    if (xiao_kernel_list_names("/sys/class/thermal", names, XIAO_THERMAL_MAX_ENTRIES, &nr))
+        nr = 0;
+
+    for (i = 0; i < nr; i++) {
+        if (strncmp(names[i], "thermal_zone", strlen("thermal_zone")) != 0)
+            continue;
+
+        if (hdr->nr_zones_total++ < query->zone_offset || hdr->nr_zones >= max_zones)
+            continue;
+        xiao_thermal_fill_zone(names[i], &zones[hdr->nr_zones++]);
+    }
+
+    kvfree(names);
+
+    cpus = (struct xiao_cpu_freq *)(zones + hdr->nr_zones);
+    max_cpus = (size - ((void *)cpus - buf)) / sizeof(*cpus);
+    if (query->cpu_max && query->cpu_max < max_cpus)
+        max_cpus = query->cpu_max;
+
+    for_each_online_cpu(cpu) {
+        if (idx < query->cpu_offset || hdr->nr_cpus >= max_cpus) {
+            if (cpufreq_cpu_get_raw(cpu))
+                idx++;
+            continue;
+        }
+
+        if (xiao_cpufreq_fill(cpu, &cpus[hdr->nr_cpus])) {
+            hdr->nr_cpus++;
+            idx++;
         }
-        filp_close(fp, NULL);
     }
 
+    hdr->total_cpus = idx;
+    *data_len = sizeof(*hdr) + hdr->nr_zones * sizeof(*zones) + hdr->nr_cpus * sizeof(*cpus);
+
+    return 0;
+}
+
+static int xiao_hw_proc_show(struct seq_file *m, void *v)
+{
+    const struct xiao_hw_info *hw = &xiao_hw_snapshot;
+
+    seq_printf(m, "xiao hardware info bridge\n");
+    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "operations: get_hw_info, get_cpu_topology, get_pci_devices,\n");
+    seq_printf(m, "            get_usb_devices, get_block_devices, get_disk_stats,\n");
+    seq_printf(m, "            get_thermal\n");
+
+    seq_printf(m, "\n--- CPU Information ---\n");
+    seq_printf(m, "Vendor: %s\n", hw->cpu_vendor);
+    seq_printf(m, "Model: %s\n", hw->cpu_model);
+    seq_printf(m, "Family/Model/Stepping: %u/%u/%u\n",
+               hw->cpu_family, hw->cpu_model_id, hw->cpu_stepping);
+    seq_printf(m, "Processors: %u online\n", num_online_cpus());
+    seq_printf(m, "BogoMIPS: %llu\n", hw->bogomips);
+    seq_printf(m, "ISA flags: 0x%llx\n", xiao_hw_isa_flags);
+
+    seq_printf(m, "\n--- Memory Information ---\n");
+    seq_printf(m, "MemTotal: %llu kB\n", hw->mem_total >> 10);
+
+    seq_printf(m, "\n--- DMI Information ---\n");
+    seq_printf(m, "System Vendor: %s\n", hw->vendor);
+    seq_printf(m, "Product Name: %s\n", hw->model);
+    seq_printf(m, "Board Name: %s\n", hw->board_name);
+    seq_printf(m, "BIOS Version: %s\n", hw->bios_version);
+    seq_printf(m, "BIOS Date: %s\n", hw->bios_date);
+
     return 0;
 }
 
@@ -222,9 +910,17 @@ static struct proc_dir_entry *xiao_hw_proc_entry;
 
 int __init xiao_hardware_init(void)
 {
+    xiao_hw_build_snapshot(&xiao_hw_snapshot);
+    xiao_hw_isa_flags = xiao_hw_isa_detect();
+
+    /* Without the table, topology queries simply report no caches */
+    xiao_hw_caches = kcalloc(nr_cpu_ids, sizeof(*xiao_hw_caches), GFP_KERNEL);
+
     xiao_hw_proc_entry = proc_create("xiao_hw", 0444, NULL, &xiao_hw_proc_fops);
     if (!xiao_hw_proc_entry) {
         pr_err("xiao_hardware: failed to create proc entry\n");
+        kfree(xiao_hw_caches);
+        xiao_hw_caches = NULL;
         return -ENOMEM;
     }
     pr_info("xiao_hardware: hardware info subsystem initialized\n");
@@ -235,5 +931,7 @@ void __exit xiao_hardware_exit(void)
 {
     if (xiao_hw_proc_entry)
         remove_proc_entry("xiao_hw", NULL);
+    kfree(xiao_hw_caches);
+    xiao_hw_caches = NULL;
     pr_info("xiao_hardware: hardware info subsystem cleanup complete\n");
 }
@@ -1,6 +1,7 @@
 #include "xiao_syscall.h"
 
 static DEFINE_MUTEX(xiao_ipc_lock);
+static DEFINE_MUTEX(xiao_nl_lock);
 static struct sock *xiao_nl_sock;
 static u32 xiao_nl_pid;
 static DECLARE_WAIT_QUEUE_HEAD(xiao_ipc_wq);
@@ -8,17 +9,79 @@ static DECLARE_WAIT_QUEUE_HEAD(xiao_ipc_wq);
 #define XIAO_NETLINK_FAMILY_NAME "xiao_bridge"
 #define XIAO_NETLINK_MULTICAST_GROUP 1
 
+/* Capability each command needs; commands left at 0 are open to every session */
+static const u32 xiao_cmd_caps[XIAO_CMD_MAX] = {
+    [XIAO_CMD_GET_PROCESSES] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_KILL_PROCESS] = XIAO_CAP_PROC_KILL,
+    [XIAO_CMD_GET_PROC_INFO] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_GET_CPU_INFO] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_MEM_INFO] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_NETWORK] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_HW_INFO] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_NET_CONFIG] = XIAO_CAP_NET_CONFIG,
+    [XIAO_CMD_SET_NET_CONFIG] = XIAO_CAP_NET_CONFIG,
+    [XIAO_CMD_PROC_EVENTS_CTL] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_GET_PROC_EVENTS] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_GET_PROC_INFO_EX] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_OPEN_PROCESS] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_HANDLE_INFO] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_HANDLE_SIGNAL] = XIAO_CAP_PROC_KILL,
+    [XIAO_CMD_HANDLE_WAIT] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_GET_THREADS] = XIAO_CAP_PROC_LIST,
+    [XIAO_CMD_GET_CPU_DETAIL] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_NUMA_MEM] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_HISTORY] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_LOAD] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_NET_RATES] = XIAO_CAP_SYS_INFO,
+    [XIAO_CMD_GET_NET_ADDRS] = XIAO_CAP_NET_CONFIG,
+    [XIAO_CMD_SET_LINK_CONFIG_BATCH] = XIAO_CAP_NET_CONFIG,
+    [XIAO_CMD_GET_SOCKETS] = XIAO_CAP_NET_CONFIG,
+    [XIAO_CMD_GET_CPU_TOPOLOGY] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_PCI_DEVICES] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_USB_DEVICES] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_BLOCK_DEVICES] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_DISK_STATS] = XIAO_CAP_HW_INFO,
+    [XIAO_CMD_GET_THERMAL] = XIAO_CAP_HW_INFO,
+};
+
+static inline u32 xiao_cmd_required_caps(u32 cmd)
+{
+    return cmd < XIAO_CMD_MAX ? xiao_cmd_caps[cmd] : 0;
+}
+
 static void xiao_netlink_rcv(struct sk_buff *skb)
 {
     struct nlmsghdr *nlh;
     struct xiao_request *req;
     struct xiao_response resp;
+    struct xiao_handle_request *hreq;
+    struct xiao_capability *cap;
+    struct net *net;
+    struct xiao_session session;
+    u64 start, latency;
     int ret;
 
     nlh = nlmsg_hdr(skb);
     req = nlmsg_data(nlh);
 
     memset(&resp, 0, sizeof(resp));
+    start = ktime_get_ns();
+    trace_xiao_cmd_submit(req->cmd, current->tgid, nlmsg_len(nlh), XIAO_TRACE_SRC_NETLINK);
+
+    /* Netlink senders have no file, so each message is its own session */
+    xiao_session_init(&session);
+    if (!xiao_session_allows(&session, xiao_cmd_required_caps(req->cmd))) {
+        resp.error = -EACCES;
+        goto out;
+    }
+
+    net = xiao_net_resolve(req);
+    if (IS_ERR(net)) {
+        resp.error = PTR_ERR(net);
+        goto out;
+    }
+
+    trace_xiao_cmd_start(req->cmd);
 
     switch (req->cmd) {
     case XIAO_CMD_READ_FILE:
@@ -70,7 +133,7 @@ static void xiao_netlink_rcv(struct sk_buff *skb)
         break;
 
     case XIAO_CMD_GET_NETWORK:
-        ret = xiao_get_network_info((struct xiao_network_info *)resp.data,
+        ret = xiao_get_network_info(net, (struct xiao_network_info *)resp.data,
                                     32, &resp.data_len);
         resp.error = ret;
         resp.data_len = ret == 0 ? resp.data_len * sizeof(struct xiao_network_info) : 0;
@@ -83,26 +146,180 @@ static void xiao_netlink_rcv(struct sk_buff *skb)
         break;
 
     case XIAO_CMD_CHECK_PERM:
-        ret = xiao_check_capability(req->pid, req->caps);
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_check_capability(req->pid, cap->caps);
         resp.error = ret;
         break;
 
     case XIAO_CMD_REQUEST_CAP:
-        ret = xiao_request_capability(req->pid, req->requested_caps,
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_request_capability(req->pid, cap->requested_caps,
                                        (u32 *)resp.data);
         resp.error = ret;
         resp.data_len = ret == 0 ? sizeof(u32) : 0;
         break;
 
+    case XIAO_CMD_REVOKE_CAP:
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_revoke_capability(req->pid, cap->caps);
+        resp.error = ret;
+        break;
+
     case XIAO_CMD_GET_NET_CONFIG:
-        ret = xiao_get_net_config((struct xiao_network_info *)resp.data,
+        ret = xiao_get_net_config(net, (struct xiao_network_info *)resp.data,
                                    32, &resp.data_len);
         resp.error = ret;
         resp.data_len = ret == 0 ? resp.data_len * sizeof(struct xiao_network_info) : 0;
         break;
 
     case XIAO_CMD_SET_NET_CONFIG:
-        ret = xiao_set_net_config(req->data, req->flags);
+        ret = xiao_set_net_config(net, req->data, req->flags);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_PROC_EVENTS_CTL:
+        ret = xiao_proc_events_ctl(NULL, NETLINK_CB(skb).portid, req->flags);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_PROC_EVENTS:
+        ret = xiao_get_proc_events(NULL, NETLINK_CB(skb).portid,
+                                   (struct xiao_proc_event_batch *)resp.data,
+                                   XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_PROC_INFO_EX:
+        ret = xiao_get_process_info_ex(req->pid, req->flags,
+                                       (struct xiao_process_info_ex *)resp.data);
+        resp.error = ret;
+        resp.data_len = ret == 0 ? sizeof(struct xiao_process_info_ex) : 0;
+        break;
+
+    case XIAO_CMD_OPEN_PROCESS:
+        ret = xiao_open_process(req->pid, (u32 *)resp.data);
+        resp.error = ret;
+        resp.data_len = ret == 0 ? sizeof(u32) : 0;
+        break;
+
+    case XIAO_CMD_CLOSE_PROCESS:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_close_process(hreq->handle);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_HANDLE_INFO:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_handle_get_info(hreq->handle, (struct xiao_process_info *)resp.data);
+        resp.error = ret;
+        resp.data_len = ret == 0 ? sizeof(struct xiao_process_info) : 0;
+        break;
+
+    case XIAO_CMD_HANDLE_SIGNAL:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_handle_signal(hreq->handle, hreq->sig);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_HANDLE_WAIT:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_handle_wait(hreq->handle, hreq->timeout_ms);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_THREADS:
+        ret = xiao_get_threads((struct xiao_thread_query *)req->data, resp.data,
+                               XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_CPU_DETAIL:
+        ret = xiao_get_cpu_detail((struct xiao_page_query *)req->data, resp.data,
+                                  XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_NUMA_MEM:
+        ret = xiao_get_numa_mem(resp.data, XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_HISTORY:
+        ret = xiao_get_history((struct xiao_history_query *)req->data, resp.data,
+                               XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_LOAD:
+        ret = xiao_get_load_info((struct xiao_load_info *)resp.data);
+        resp.error = ret;
+        resp.data_len = ret == 0 ? sizeof(struct xiao_load_info) : 0;
+        break;
+
+    case XIAO_CMD_GET_NET_RATES:
+        ret = xiao_get_net_rates(resp.data, XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_NET_ADDRS:
+        ret = xiao_get_net_addrs(net, (struct xiao_page_query *)req->data, resp.data,
+                                 XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_SET_LINK_CONFIG_BATCH:
+        ret = xiao_set_link_config_batch(net, (struct xiao_link_batch *)req->data,
+                                         min_t(u32, req->data_len, XIAO_MAX_PATH),
+                                         (struct xiao_link_batch_result *)resp.data,
+                                         &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_SOCKETS:
+        ret = xiao_get_sockets(net, (struct xiao_socket_query *)req->data, resp.data,
+                               XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_CPU_TOPOLOGY:
+        ret = xiao_get_cpu_topology((struct xiao_page_query *)req->data, resp.data,
+                                    XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_PCI_DEVICES:
+        ret = xiao_get_pci_devices((struct xiao_page_query *)req->data, resp.data,
+                                   XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_USB_DEVICES:
+        ret = xiao_get_usb_devices((struct xiao_page_query *)req->data, resp.data,
+                                   XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_BLOCK_DEVICES:
+        ret = xiao_get_block_devices((struct xiao_page_query *)req->data, resp.data,
+                                     XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_DISK_STATS:
+        ret = xiao_get_disk_stats((struct xiao_page_query *)req->data, resp.data,
+                                  XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_GET_THERMAL:
+        ret = xiao_get_thermal((struct xiao_thermal_query *)req->data, resp.data,
+                               XIAO_MAX_PAYLOAD, &resp.data_len);
+        resp.error = ret;
+        break;
+
+    case XIAO_CMD_READ_AUDIT:
+        ret = xiao_read_audit((struct xiao_audit_batch *)resp.data,
+                              XIAO_MAX_PAYLOAD, &resp.data_len);
         resp.error = ret;
         break;
 
@@ -112,6 +329,14 @@ static void xiao_netlink_rcv(struct sk_buff *skb)
         break;
     }
 
+    if (net)
+        put_net(net);
+
+out:
+    xiao_audit_command(req, xiao_cmd_required_caps(req->cmd), resp.error);
+    latency = ktime_get_ns() - start;
+    xiao_stats_record(req->cmd, resp.error, nlmsg_len(nlh), resp.data_len, latency);
+    trace_xiao_cmd_done(req->cmd, resp.error, latency);
     xiao_send_netlink_response(skb, &resp);
 }
 
@@ -141,26 +366,78 @@ int xiao_send_netlink_response(struct sk_buff *skb, struct xiao_response *resp)
     return ret;
 }
 
+/*
+ * NETLINK_USERSOCK lets unprivileged sockets send to its multicast groups
+ * as well, so listeners must drop any message whose sender portid is not 0
+ * (the kernel) rather than trust everything that arrives on the group.
+ */
+int xiao_ipc_broadcast(u16 type, const void *data, u32 len)
+{
+    struct nlmsghdr *nlh;
+    struct sk_buff *skb;
+    int ret;
+
+    skb = nlmsg_new(len, GFP_KERNEL);
+    if (!skb)
+        return -ENOMEM;
+
+    nlh = nlmsg_put(skb, 0, 0, type, len, 0);
+    if (!nlh) {
+        kfree_skb(skb);
+        return -EMSGSIZE;
+    }
+
+    memcpy(nlmsg_data(nlh), data, len);
+
+    mutex_lock(&xiao_nl_lock);
+    if (xiao_nl_sock) {
+        ret = nlmsg_multicast(xiao_nl_sock, skb, 0, XIAO_NETLINK_MULTICAST_GROUP, GFP_KERNEL);
+    } else {
+        kfree_skb(skb);
+        ret = -ENOTCONN;
+    }
+    mutex_unlock(&xiao_nl_lock);
+
+    /* No subscribers is not an error */
+    return ret == -ESRCH ? 0 : ret;
+}
+
 int xiao_proc_open(struct inode *inode, struct file *file)
 {
-    mutex_lock(&xiao_ipc_lock);
+    struct xiao_session *session;
+
+    session = kzalloc(sizeof(*session), GFP_KERNEL);
+    if (!session)
+        return -ENOMEM;
+
+    xiao_session_init(session);
+    file->private_data = session;
     return 0;
 }
 
 int xiao_proc_release(struct inode *inode, struct file *file)
 {
-    mutex_unlock(&xiao_ipc_lock);
+    struct xiao_session *session = file->private_data;
+
+    if (session->events)
+        xiao_proc_events_ctl(session, 0, 0);
+    kfree(session);
+    file->private_data = NULL;
     return 0;
 }
 
 ssize_t xiao_proc_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 {
+    struct xiao_session *session = file->private_data;
     char *kbuf;
     int ret;
 
     if (count < sizeof(struct xiao_response))
         return -EINVAL;
 
+    if (!xiao_session_allows(session, XIAO_CAP_SYS_INFO))
+        return -EACCES;
+
     kbuf = kzalloc(XIAO_MAX_PAYLOAD + sizeof(struct xiao_response), GFP_KERNEL);
     if (!kbuf)
         return -ENOMEM;
@@ -187,9 +464,14 @@ ssize_t xiao_proc_read(struct file *file, char __user *buf, size_t count, loff_t
 
 ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
 {
+    struct xiao_session *session = file->private_data;
+    struct xiao_capability *cap;
     struct xiao_request *req;
     struct xiao_response *resp;
+    struct xiao_handle_request *hreq;
+    struct net *net;
     char *kbuf;
+    u64 start, latency;
     int ret;
 
     if (count < sizeof(struct xiao_request))
@@ -214,6 +496,22 @@ ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count,
         return -ENOMEM;
     }
 
+    start = ktime_get_ns();
+    trace_xiao_cmd_submit(req->cmd, current->tgid, count, XIAO_TRACE_SRC_PROC);
+
+    if (!xiao_session_allows(session, xiao_cmd_required_caps(req->cmd))) {
+        resp->error = -EACCES;
+        goto out;
+    }
+
+    net = xiao_net_resolve(req);
+    if (IS_ERR(net)) {
+        resp->error = PTR_ERR(net);
+        goto out;
+    }
+
+    trace_xiao_cmd_start(req->cmd);
+
     mutex_lock(&xiao_ipc_lock);
 
     switch (req->cmd) {
@@ -267,7 +565,7 @@ ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count,
         break;
 
     case XIAO_CMD_GET_NETWORK:
-        ret = xiao_get_network_info((struct xiao_network_info *)resp->data,
+        ret = xiao_get_network_info(net, (struct xiao_network_info *)resp->data,
                                     32, &resp->data_len);
         resp->error = ret;
         resp->data_len = ret == 0 ? resp->data_len * sizeof(struct xiao_network_info) : 0;
@@ -280,26 +578,182 @@ ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count,
         break;
 
     case XIAO_CMD_CHECK_PERM:
-        ret = xiao_check_capability(req->pid, req->caps);
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_check_capability(req->pid, cap->caps);
         resp->error = ret;
         break;
 
     case XIAO_CMD_REQUEST_CAP:
-        ret = xiao_request_capability(req->pid, req->requested_caps,
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_request_capability(req->pid, cap->requested_caps,
                                        (u32 *)resp->data);
         resp->error = ret;
         resp->data_len = ret == 0 ? sizeof(u32) : 0;
         break;
 
+    case XIAO_CMD_REVOKE_CAP:
+        cap = (struct xiao_capability *)req->data;
+        ret = xiao_revoke_capability(req->pid, cap->caps);
+        resp->error = ret;
+        break;
+
     case XIAO_CMD_GET_NET_CONFIG:
-        ret = xiao_get_net_config((struct xiao_network_info *)resp->data,
+        ret = xiao_get_net_config(net, (struct xiao_network_info *)resp->data,
                                    32, &resp->data_len);
         resp->error = ret;
         resp->data_len = ret == 0 ? resp->data_len * sizeof(struct xiao_network_info) : 0;
         break;
 
     case XIAO_CMD_SET_NET_CONFIG:
-        ret = xiao_set_net_config(req->data, req->flags);
+        ret = xiao_set_net_config(net, req->data, req->flags);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_PROC_EVENTS_CTL:
+        ret = xiao_proc_events_ctl(session, 0, req->flags);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_PROC_EVENTS:
+        ret = xiao_get_proc_events(session, 0, (struct xiao_proc_event_batch *)resp->data,
+                                   XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_PROC_INFO_EX:
+        ret = xiao_get_process_info_ex(req->pid, req->flags,
+                                       (struct xiao_process_info_ex *)resp->data);
+        resp->error = ret;
+        resp->data_len = ret == 0 ? sizeof(struct xiao_process_info_ex) : 0;
+        break;
+
+    case XIAO_CMD_OPEN_PROCESS:
+        ret = xiao_open_process(req->pid, (u32 *)resp->data);
+        resp->error = ret;
+        resp->data_len = ret == 0 ? sizeof(u32) : 0;
+        break;
+
+    case XIAO_CMD_CLOSE_PROCESS:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_close_process(hreq->handle);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_HANDLE_INFO:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_handle_get_info(hreq->handle, (struct xiao_process_info *)resp->data);
+        resp->error = ret;
+        resp->data_len = ret == 0 ? sizeof(struct xiao_process_info) : 0;
+        break;
+
+    case XIAO_CMD_HANDLE_SIGNAL:
+        hreq = (struct xiao_handle_request *)req->data;
+        ret = xiao_handle_signal(hreq->handle, hreq->sig);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_HANDLE_WAIT:
+        hreq = (struct xiao_handle_request *)req->data;
+        /* Never sleep on a process with every other bridge client queued behind us */
+        mutex_unlock(&xiao_ipc_lock);
+        ret = xiao_handle_wait(hreq->handle, hreq->timeout_ms);
+        mutex_lock(&xiao_ipc_lock);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_THREADS:
+        ret = xiao_get_threads((struct xiao_thread_query *)req->data, resp->data,
+                               XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_CPU_DETAIL:
+        ret = xiao_get_cpu_detail((struct xiao_page_query *)req->data, resp->data,
+                                  XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_NUMA_MEM:
+        ret = xiao_get_numa_mem(resp->data, XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_HISTORY:
+        ret = xiao_get_history((struct xiao_history_query *)req->data, resp->data,
+                               XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_LOAD:
+        ret = xiao_get_load_info((struct xiao_load_info *)resp->data);
+        resp->error = ret;
+        resp->data_len = ret == 0 ? sizeof(struct xiao_load_info) : 0;
+        break;
+
+    case XIAO_CMD_GET_NET_RATES:
+        ret = xiao_get_net_rates(resp->data, XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_NET_ADDRS:
+        ret = xiao_get_net_addrs(net, (struct xiao_page_query *)req->data, resp->data,
+                                 XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_SET_LINK_CONFIG_BATCH:
+        ret = xiao_set_link_config_batch(net, (struct xiao_link_batch *)req->data,
+                                         min_t(u32, req->data_len, XIAO_MAX_PATH),
+                                         (struct xiao_link_batch_result *)resp->data,
+                                         &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_SOCKETS:
+        ret = xiao_get_sockets(net, (struct xiao_socket_query *)req->data, resp->data,
+                               XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_CPU_TOPOLOGY:
+        ret = xiao_get_cpu_topology((struct xiao_page_query *)req->data, resp->data,
+                                    XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_PCI_DEVICES:
+        ret = xiao_get_pci_devices((struct xiao_page_query *)req->data, resp->data,
+                                   XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_USB_DEVICES:
+        ret = xiao_get_usb_devices((struct xiao_page_query *)req->data, resp->data,
+                                   XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_BLOCK_DEVICES:
+        ret = xiao_get_block_devices((struct xiao_page_query *)req->data, resp->data,
+                                     XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_DISK_STATS:
+        ret = xiao_get_disk_stats((struct xiao_page_query *)req->data, resp->data,
+                                  XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_GET_THERMAL:
+        ret = xiao_get_thermal((struct xiao_thermal_query *)req->data, resp->data,
+                               XIAO_MAX_PAYLOAD, &resp->data_len);
+        resp->error = ret;
+        break;
+
+    case XIAO_CMD_READ_AUDIT:
+        ret = xiao_read_audit((struct xiao_audit_batch *)resp->data,
+                              XIAO_MAX_PAYLOAD, &resp->data_len);
         resp->error = ret;
         break;
 
@@ -310,6 +764,14 @@ ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count,
 
     mutex_unlock(&xiao_ipc_lock);
 
+    if (net)
+        put_net(net);
+
+out:
+    xiao_audit_command(req, xiao_cmd_required_caps(req->cmd), resp->error);
+    latency = ktime_get_ns() - start;
+    xiao_stats_record(req->cmd, resp->error, count, resp->data_len, latency);
+    trace_xiao_cmd_done(req->cmd, resp->error, latency);
     ret = copy_to_user(buf, resp, sizeof(struct xiao_response));
     if (ret)
         ret = -EFAULT;
@@ -329,6 +791,7 @@ static int xiao_ipc_proc_show(struct seq_file *m, void *v)
     seq_printf(m, "netlink: %s\n", xiao_nl_sock ? "active" : "inactive");
     seq_printf(m, "operations: read, write (synchronous IPC)\n");
     seq_printf(m, "netlink: async IPC (family: %s)\n", XIAO_NETLINK_FAMILY_NAME);
+    seq_printf(m, "multicast: group %d (link events, sender portid 0)\n", XIAO_NETLINK_MULTICAST_GROUP);
     return 0;
 }
 
@@ -360,6 +823,7 @@ int __init xiao_ipc_init(void)
 {
     struct netlink_kernel_cfg cfg = {
         .input = xiao_netlink_rcv,
+        .groups = XIAO_NETLINK_MULTICAST_GROUP,
     };
 
     xiao_nl_sock = netlink_kernel_create(&init_net, NETLINK_USERSOCK, &cfg);
@@ -372,8 +836,13 @@ int __init xiao_ipc_init(void)
     xiao_ipc_proc_entry = proc_create("xiao_ipc", 0444, NULL, &xiao_ipc_proc_fops);
     if (!xiao_ipc_proc_entry) {
         pr_err("xiao_ipc: failed to create proc entry\n");
-        if (xiao_nl_sock)
+        xiao_net_notify_cancel();
+        mutex_lock(&xiao_nl_lock);
+        if (xiao_nl_sock) {
             netlink_kernel_release(xiao_nl_sock);
+            xiao_nl_sock = NULL;
+        }
+        mutex_unlock(&xiao_nl_lock);
         return -ENOMEM;
     }
 
@@ -386,10 +855,12 @@ void __exit xiao_ipc_exit(void)
     if (xiao_ipc_proc_entry)
         remove_proc_entry("xiao_ipc", NULL);
 
+    mutex_lock(&xiao_nl_lock);
     if (xiao_nl_sock) {
         netlink_kernel_release(xiao_nl_sock);
         xiao_nl_sock = NULL;
     }
+    mutex_unlock(&xiao_nl_lock);
 
     pr_info("xiao_ipc: IPC subsystem cleanup complete\n");
 }
@@ -1,65 +1,175 @@
 #include "xiao_syscall.h"
 
 static DEFINE_MUTEX(xiao_net_lock);
+static DEFINE_SPINLOCK(xiao_net_rate_lock);
+static DEFINE_SPINLOCK(xiao_notify_lock);
 
-int xiao_get_net_config(struct xiao_network_info __user *info, u32 max_count, u32 __user *count)
+/*
+ * Exponentially weighted rate with a weight of 1/16 and 10 bits of
+ * fraction. The kernel's DECLARE_EWMA keeps an unsigned long, which
+ * overflows at about 4 MB/s on 32-bit once the fraction is added, so
+ * the state here is always 64 bits wide.
+ */
+#define XIAO_RATE_EWMA_PREC   10
+#define XIAO_RATE_EWMA_WRECIP 4
+
+struct xiao_rate_ewma {
+    u64 internal;
+};
+
+static inline void xiao_rate_ewma_init(struct xiao_rate_ewma *e)
 {
-    struct xiao_network_info ninfo;
-    struct net_device *dev;
+    e->internal = 0;
+}
+
+static inline void xiao_rate_ewma_add(struct xiao_rate_ewma *e, u64 val)
+{
+    u64 internal = e->internal;
+
+    e->internal = internal ?
+        (((internal << XIAO_RATE_EWMA_WRECIP) - internal) +
+         (val << XIAO_RATE_EWMA_PREC)) >> XIAO_RATE_EWMA_WRECIP :
+        val << XIAO_RATE_EWMA_PREC;
+}
+
+static inline u64 xiao_rate_ewma_read(const struct xiao_rate_ewma *e)
+{
+    return e->internal >> XIAO_RATE_EWMA_PREC;
+}
+
+struct xiao_net_rate_state {
+    int ifindex;
+    bool seen;
+    char name[IFNAMSIZ];
+    struct rtnl_link_stats64 last;
+    struct xiao_rate_ewma rx_bps;
+    struct xiao_rate_ewma tx_bps;
+    struct xiao_rate_ewma rx_pps;
+    struct xiao_rate_ewma tx_pps;
+    struct xiao_rate_ewma rx_drops;
+    struct xiao_rate_ewma tx_drops;
+};
+
+static struct xiao_net_rate_state xiao_net_rates[XIAO_NET_MAX_IFACES];
+static u64 xiao_net_rate_ts;
+
+/*
+ * Network commands act on the caller's namespace, or on the one behind
+ * req->netns_fd when XIAO_NS_F_NET is set in req->ns_flags. Commands that
+ * change configuration also need CAP_NET_ADMIN over the target namespace.
+ * Other commands get NULL.
+ */
+struct net *xiao_net_resolve(const struct xiao_request *req)
+{
+    struct net *net;
+    bool write;
+
+    switch (req->cmd) {
+    case XIAO_CMD_GET_NETWORK:
+    case XIAO_CMD_GET_NET_CONFIG:
+    case XIAO_CMD_GET_NET_ADDRS:
+    case XIAO_CMD_GET_SOCKETS:
+        write = false;
+        break;
+    case XIAO_CMD_SET_NET_CONFIG:
+    case XIAO_CMD_SET_LINK_CONFIG_BATCH:
+        write = true;
+        break;
+    default:
+        return NULL;
+    }
+
+    if (req->ns_flags & XIAO_NS_F_NET)
+        net = get_net_ns_by_fd(req->netns_fd);
+    else
+        net = get_net(current->nsproxy->net_ns);
+
+    if (IS_ERR(net))
+        return net;
+
+    if (write && !ns_capable(net->user_ns, CAP_NET_ADMIN)) {
+        put_net(net);
+        return ERR_PTR(-EPERM);
+    }
+
+    return net;
+}
+
+static void xiao_net_fill_info(struct net_device *dev, struct xiao_network_info *ninfo)
+{
+    struct rtnl_link_stats64 stats;
     struct in_device *in_dev;
-    u32 count_val = 0;
-    int ret;
+    struct in_ifaddr *ifa;
 
-    if (!info || !count)
-        return -EINVAL;
+    memset(ninfo, 0, sizeof(*ninfo));
+    strscpy(ninfo->name, dev->name, sizeof(ninfo->name));
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_NET_CONFIG);
-    if (ret)
-        return ret;
+    in_dev = __in_dev_get_rcu(dev);
+    if (in_dev) {
+        ifa = rcu_dereference(in_dev->ifa_list);
+        if (ifa) {
+            snprintf(ninfo->ip, sizeof(ninfo->ip), "%pI4", &ifa->ifa_address);
+            snprintf(ninfo->netmask, sizeof(ninfo->netmask), "%pI4", &ifa->ifa_mask);
+        }
+    }
+
+    if (dev->addr_len <= sizeof(ninfo->mac)) {
+        snprintf(ninfo->mac, sizeof(ninfo->mac), "%pM", dev->dev_addr);
+    }
 
-    mutex_lock(&xiao_net_lock);
+    dev_get_stats(dev, &stats);
+    ninfo->rx_bytes = stats.rx_bytes;
+    ninfo->tx_bytes = stats.tx_bytes;
+    ninfo->rx_packets = stats.rx_packets;
+    ninfo->tx_packets = stats.tx_packets;
+    ninfo->mtu = READ_ONCE(dev->mtu);
+    ninfo->flags = READ_ONCE(dev->flags);
+}
 
-    rtnl_lock();
+u32 xiao_net_snapshot(struct net *net, struct xiao_network_info *info, u32 max_count)
+{
+    struct net_device *dev;
+    u32 count = 0;
+
+    rcu_read_lock();
 
-    for_each_netdev(&init_net, dev) {
-        if (count_val >= max_count)
+    for_each_netdev_rcu(net, dev) {
+        if (count >= max_count)
             break;
 
         if (dev->flags & IFF_LOOPBACK)
             continue;
 
-        memset(&ninfo, 0, sizeof(ninfo));
-        strncpy(ninfo.name, dev->name, sizeof(ninfo.name) - 1);
+        xiao_net_fill_info(dev, &info[count]);
+        count++;
+    }
 
-        in_dev = dev->ip_ptr;
-        if (in_dev && in_dev->ifa_list) {
-            snprintf(ninfo.ip, sizeof(ninfo.ip), "%pI4", &in_dev->ifa_list->ifa_address);
-            snprintf(ninfo.netmask, sizeof(ninfo.netmask), "%pI4",
-                     &in_dev->ifa_list->ifa_mask);
-        }
+    rcu_read_unlock();
 
-        if (dev->addr_len <= sizeof(ninfo.mac)) {
-            snprintf(ninfo.mac, sizeof(ninfo.mac), "%pM", dev->dev_addr);
-        }
+    return count;
+}
 
-        ninfo.rx_bytes = dev->stats.rx_bytes;
-        ninfo.tx_bytes = dev->stats.tx_bytes;
-        ninfo.rx_packets = dev->stats.rx_packets;
-        ninfo.tx_packets = dev->stats.tx_packets;
-        ninfo.mtu = dev->mtu;
-        ninfo.flags = dev->flags;
-
-        if (copy_to_user(&info[count_val], &ninfo, sizeof(ninfo))) {
-            rtnl_unlock();
-            mutex_unlock(&xiao_net_lock);
-            return -EFAULT;
-        }
-        count_val++;
-    }
+int xiao_get_net_config(struct net *net, struct xiao_network_info __user *info, u32 max_count,
+                        u32 __user *count)
+{
+    struct xiao_network_info *ninfo;
+    u32 count_val;
 
-    rtnl_unlock();
+    if (!info || !count)
+        return -EINVAL;
 
-    mutex_unlock(&xiao_net_lock);
+    ninfo = kcalloc(max_count, sizeof(*ninfo), GFP_KERNEL);
+    if (!ninfo)
+        return -ENOMEM;
+
+    count_val = xiao_net_snapshot(net, ninfo, max_count);
+
+    if (copy_to_user(info, ninfo, count_val * sizeof(*ninfo))) {
+        kfree(ninfo);
+        return -EFAULT;
+    }
+
+    kfree(ninfo);
 
     if (put_user(count_val, count))
         return -EFAULT;
@@ -67,7 +177,7 @@ int xiao_get_net_config(struct xiao_network_info __user *info, u32 max_count, u3
     return 0;
 }
 
-int xiao_set_net_config(const char __user *ifname, u32 flags)
+int xiao_set_net_config(struct net *net, const char __user *ifname, u32 flags)
 {
     struct net_device *dev;
     char ifname_buf[IFNAMSIZ];
@@ -76,10 +186,6 @@ int xiao_set_net_config(const char __user *ifname, u32 flags)
     if (!ifname)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_NET_CONFIG);
-    if (ret)
-        return ret;
-
     if (strnlen_user(ifname, IFNAMSIZ) >= IFNAMSIZ)
         return -ENAMETOOLONG;
 
@@ -88,11 +194,11 @@ int xiao_set_net_config(const char __user *ifname, u32 flags)
 
     ifname_buf[IFNAMSIZ - 1] = '\0';
 
-    mutex_lock(&xiao_net_lock);
+    xiao_mutex_lock_traced(&xiao_net_lock, XIAO_LOCK_NET);
 
     rtnl_lock();
 
-    dev = dev_get_by_name(&init_net, ifname_buf);
+    dev = dev_get_by_name(net, ifname_buf);
     if (!dev) {
         ret = -ENODEV;
         goto out;
@@ -118,37 +224,854 @@ out:
     return ret;
 }
 
+struct xiao_link_undo {
+    struct net_device *dev;
+    u32 done;
+    u32 old_mtu;
+    u32 old_flags;
+};
+
+static int xiao_link_apply_entry(const struct xiao_link_cfg_entry *entry,
+                                struct xiao_link_undo *undo)
+{
+    struct net_device *dev = undo->dev;
+    int ret;
+
+    undo->old_mtu = dev->mtu;
+    undo->old_flags = dev->flags;
+
+    if ((entry->mask & XIAO_LINKCFG_MTU) && entry->mtu != dev->mtu) {
+        ret = dev_set_mtu(dev, entry->mtu);
+        if (ret)
+            return ret;
+        undo->done |= XIAO_LINKCFG_MTU;
+    }
+
+    if ((entry->mask & XIAO_LINKCFG_STATE) &&
+        ((entry->flags ^ dev->flags) & IFF_UP)) {
+        ret = dev_change_flags(dev, (dev->flags & ~IFF_UP) | (entry->flags & IFF_UP), NULL);
+        if (ret)
+            return ret;
+        undo->done |= XIAO_LINKCFG_STATE;
+    }
+
+    return 0;
+}
+
+static void xiao_link_undo_entry(struct xiao_link_undo *undo)
+{
+    struct net_device *dev = undo->dev;
+
+    if (undo->done & XIAO_LINKCFG_STATE)
+        dev_change_flags(dev, (dev->flags & ~IFF_UP) | (undo->old_flags & IFF_UP), NULL);
+    if (undo->done & XIAO_LINKCFG_MTU)
+        dev_set_mtu(dev, undo->old_mtu);
+}
+
+int xiao_set_link_config_batch(struct net *net, const struct xiao_link_batch *batch, u32 len,
+                               struct xiao_link_batch_result *result, u32 *data_len)
+{
+    struct xiao_link_undo *undo;
+    const struct xiao_link_cfg_entry *entry;
+    u32 i, applied = 0;
+    int ret;
+
+    if (!batch || !result || !data_len || len < sizeof(*batch))
+        return -EINVAL;
+
+    if (!batch->count || batch->count > XIAO_LINK_BATCH_MAX ||
+        len < sizeof(*batch) + batch->count * sizeof(*entry))
+        return -EINVAL;
+
+    result->applied = 0;
+    result->failed_index = -1;
+    *data_len = sizeof(*result);
+
+    for (i = 0; i < batch->count; i++) {
+        entry = &batch->entries[i];
+        if (strnlen(entry->ifname, IFNAMSIZ) >= IFNAMSIZ) {
+            result->failed_index = i;
+            return -ENAMETOOLONG;
+        }
+        if (entry->mask & ~(XIAO_LINKCFG_STATE | XIAO_LINKCFG_MTU)) {
+            result->failed_index = i;
+            return -EOPNOTSUPP;
+        }
+    }
+
+    undo = kcalloc(batch->count, sizeof(*undo), GFP_KERNEL);
+    if (!undo)
+        return -ENOMEM;
+
+    xiao_mutex_lock_traced(&xiao_net_lock, XIAO_LOCK_NET);
+    rtnl_lock();
+
+    /* Resolve every device first so a bad name fails before anything changes */
+    for (i = 0; i < batch->count; i++) {
+        undo[i].dev = __dev_get_by_name(net, batch->entries[i].ifname);
+        if (!undo[i].dev) {
+            result->failed_index = i;
+            ret = -ENODEV;
+            goto out;
+        }
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        ret = xiao_link_apply_entry(&batch->entries[i], &undo[i]);
+        if (ret) {
+            result->failed_index = i;
+            break;
+        }
+        applied++;
+    }
+
+    if (ret) {
+        /* All or nothing: unwind the failed entry and everything before it */
+        xiao_link_undo_entry(&undo[applied]);
+        while (applied--)
+            xiao_link_undo_entry(&undo[applied]);
+        applied = 0;
+    }
+
+out:
+    rtnl_unlock();
+    mutex_unlock(&xiao_net_lock);
+
+    result->applied = applied;
+    kfree(undo);
+    return ret;
+}
+
+void xiao_net_totals(u64 *rx_bytes, u64 *tx_bytes)
+{
+    struct rtnl_link_stats64 stats;
+    struct net_device *dev;
+    u64 rx = 0, tx = 0;
+
+    rcu_read_lock();
+    for_each_netdev_rcu(&init_net, dev) {
+        if (dev->flags & IFF_LOOPBACK)
+            continue;
+        dev_get_stats(dev, &stats);
+        rx += stats.rx_bytes;
+        tx += stats.tx_bytes;
+    }
+    rcu_read_unlock();
+
+    *rx_bytes = rx;
+    *tx_bytes = tx;
+}
+
+static struct xiao_net_rate_state *xiao_net_rate_slot(struct net_device *dev, bool *fresh)
+{
+    struct xiao_net_rate_state *st;
+    struct xiao_net_rate_state *free_slot = NULL;
+    int i;
+
+    for (i = 0; i < XIAO_NET_MAX_IFACES; i++) {
+        st = &xiao_net_rates[i];
+        if (st->ifindex == dev->ifindex) {
+            *fresh = false;
+            return st;
+        }
+        if (!st->ifindex && !free_slot)
+            free_slot = st;
+    }
+
+    if (free_slot) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->ifindex = dev->ifindex;
+        xiao_rate_ewma_init(&free_slot->rx_bps);
+        xiao_rate_ewma_init(&free_slot->tx_bps);
+        xiao_rate_ewma_init(&free_slot->rx_pps);
+        xiao_rate_ewma_init(&free_slot->tx_pps);
+        xiao_rate_ewma_init(&free_slot->rx_drops);
+        xiao_rate_ewma_init(&free_slot->tx_drops);
+        *fresh = true;
+    }
+
+    return free_slot;
+}
+
+static u64 xiao_per_sec(u64 now, u64 last, u64 elapsed_ns)
+{
+    if (now < last || !elapsed_ns)
+        return 0;
+    return div64_u64((now - last) * NSEC_PER_SEC, elapsed_ns);
+}
+
+void xiao_net_sample(u64 now_ns)
+{
+    struct xiao_net_rate_state *st;
+    struct rtnl_link_stats64 stats;
+    struct net_device *dev;
+    u64 elapsed;
+    bool fresh;
+    int i;
+
+    spin_lock(&xiao_net_rate_lock);
+
+    elapsed = xiao_net_rate_ts ? now_ns - xiao_net_rate_ts : 0;
+    xiao_net_rate_ts = now_ns;
+
+    for (i = 0; i < XIAO_NET_MAX_IFACES; i++)
+        xiao_net_rates[i].seen = false;
+
+    rcu_read_lock();
+
+    for_each_netdev_rcu(&init_net, dev) {
+        if (dev->flags & IFF_LOOPBACK)
+            continue;
+
+        /* Keep walking: devices further down may already own a slot */
+        st = xiao_net_rate_slot(dev, &fresh);
+        if (!st)
+            continue;
+
+        dev_get_stats(dev, &stats);
+
+        if (!fresh && elapsed) {
+            xiao_rate_ewma_add(&st->rx_bps, xiao_per_sec(stats.rx_bytes, st->last.rx_bytes, elapsed));
+            xiao_rate_ewma_add(&st->tx_bps, xiao_per_sec(stats.tx_bytes, st->last.tx_bytes, elapsed));
+            xiao_rate_ewma_add(&st->rx_pps, xiao_per_sec(stats.rx_packets, st->last.rx_packets, elapsed));
+            xiao_rate_ewma_add(&st->tx_pps, xiao_per_sec(stats.tx_packets, st->last.tx_packets, elapsed));
+            xiao_rate_ewma_add(&st->rx_drops, xiao_per_sec(stats.rx_dropped, st->last.rx_dropped, elapsed));
+            xiao_rate_ewma_add(&st->tx_drops, xiao_per_sec(stats.tx_dropped, st->last.tx_dropped, elapsed));
+        }
+
+        strscpy(st->name, dev->name, sizeof(st->name));
+        st->last = stats;
+        st->seen = true;
+    }
+
+    rcu_read_unlock();
+
+    for (i = 0; i < XIAO_NET_MAX_IFACES; i++) {
+        if (!xiao_net_rates[i].seen)
+            xiao_net_rates[i].ifindex = 0;
+    }
+
+    spin_unlock(&xiao_net_rate_lock);
+}
+
+int xiao_get_net_rates(void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_net_rate *out = (struct xiao_net_rate *)(hdr + 1);
+    struct xiao_net_rate_state *st;
+    u32 max_out, count = 0;
+    int i;
+
+    if (!buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+
+    spin_lock(&xiao_net_rate_lock);
+
+    for (i = 0; i < XIAO_NET_MAX_IFACES && count < max_out; i++) {
+        st = &xiao_net_rates[i];
+        if (!st->ifindex)
+            continue;
+
+        memset(out, 0, sizeof(*out));
+        strscpy(out->name, st->name, sizeof(out->name));
+        out->ifindex = st->ifindex;
+        out->rx_bps = xiao_rate_ewma_read(&st->rx_bps);
+        out->tx_bps = xiao_rate_ewma_read(&st->tx_bps);
+        out->rx_pps = xiao_rate_ewma_read(&st->rx_pps);
+        out->tx_pps = xiao_rate_ewma_read(&st->tx_pps);
+        out->rx_drops = xiao_rate_ewma_read(&st->rx_drops);
+        out->tx_drops = xiao_rate_ewma_read(&st->tx_drops);
+        out++;
+        count++;
+    }
+
+    spin_unlock(&xiao_net_rate_lock);
+
+    hdr->total = count;
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_net_rate);
+
+    return 0;
+}
+
+static bool xiao_net_addr_slot(const struct xiao_page_query *query, u32 idx, u32 count, u32 max_out)
+{
+    return idx >= query->offset && count < max_out;
+}
+
+#if IS_ENABLED(CONFIG_IPV6)
+static u8 xiao_inet6_scope(int scope)
+{
+    if (scope & IPV6_ADDR_LOOPBACK)
+        return RT_SCOPE_HOST;
+    if (scope & IPV6_ADDR_LINKLOCAL)
+        return RT_SCOPE_LINK;
+    if (scope & IPV6_ADDR_SITELOCAL)
+        return RT_SCOPE_SITE;
+    return RT_SCOPE_UNIVERSE;
+}
+#endif
+
+int xiao_get_net_addrs(struct net *net, const struct xiao_page_query *query, void *buf, u32 size,
+                       u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_net_addr *out = (struct xiao_net_addr *)(hdr + 1);
+    struct net_device *dev;
+    struct in_device *in_dev;
+    struct in_ifaddr *ifa;
+#if IS_ENABLED(CONFIG_IPV6)
+    struct inet6_dev *idev;
+    struct inet6_ifaddr *ifp;
+#endif
+    u32 max_out, count = 0, idx = 0;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    rcu_read_lock();
+
+    for_each_netdev_rcu(net, dev) {
+        in_dev = __in_dev_get_rcu(dev);
+        if (in_dev) {
+            in_dev_for_each_ifa_rcu(ifa, in_dev) {
+                if (xiao_net_addr_slot(query, idx, count, max_out)) {
+                    memset(out, 0, sizeof(*out));
+                    out->ifindex = dev->ifindex;
+                    out->family = AF_INET;
+                    out->prefixlen = ifa->ifa_prefixlen;
+                    out->scope = ifa->ifa_scope;
+                    out->flags = ifa->ifa_flags;
+                    memcpy(out->addr, &ifa->ifa_local, sizeof(ifa->ifa_local));
+                    strscpy(out->ifname, dev->name, sizeof(out->ifname));
+                    out++;
+                    count++;
+                }
+                idx++;
+            }
+        }
+
+#if IS_ENABLED(CONFIG_IPV6)
+        idev = __in6_dev_get(dev);
+        if (idev) {
+            read_lock_bh(&idev->lock);
+            list_for_each_entry(ifp, &idev->addr_list, if_list) {
+                if (xiao_net_addr_slot(query, idx, count, max_out)) {
+                    memset(out, 0, sizeof(*out));
+                    out->ifindex = dev->ifindex;
+                    out->family = AF_INET6;
+                    out->prefixlen = ifp->prefix_len;
+                    out->scope = xiao_inet6_scope(ifp->scope);
+                    out->flags = ifp->flags;
+                    memcpy(out->addr, &ifp->addr, sizeof(ifp->addr));
+                    strscpy(out->ifname, dev->name, sizeof(out->ifname));
+                    out++;
+                    count++;
+                }
+                idx++;
+            }
+            read_unlock_bh(&idev->lock);
+        }
+#endif
+    }
+
+    rcu_read_unlock();
+
+    hdr->total = idx;
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_net_addr);
+
+    return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+/*
+ * Sockets owned by a pid are matched by inode number rather than by
+ * struct sock pointer: the fd table is sampled before the hash walk and
+ * holds no references, so a pointer could be freed and reused meanwhile.
+ */
+struct xiao_sock_walk {
+    const struct xiao_socket_query *query;
+    struct net *net;
+    unsigned long *owned;
+    u32 nr_owned;
+    u32 flags;
+    struct xiao_socket_info *out;
+    u32 max_out;
+    u32 count;
+    u32 idx;
+};
+
+/* iterate_fd() hands its context back as const; the walk it fills is not */
+struct xiao_sock_collect {
+    struct xiao_sock_walk *walk;
+};
+
+static int xiao_sock_collect_fd(const void *priv, struct file *file, unsigned int fd)
+{
+    const struct xiao_sock_collect *collect = priv;
+    struct xiao_sock_walk *walk = collect->walk;
+    struct socket *sock = sock_from_file(file);
+
+    if (!sock)
+        return 0;
+
+    if (walk->nr_owned >= XIAO_SOCK_MAX_OWNED) {
+        walk->flags |= XIAO_SOCK_F_OWNED_TRUNC;
+        return 0;
+    }
+
+    walk->owned[walk->nr_owned++] = SOCK_INODE(sock)->i_ino;
+    return 0;
+}
+
+static int xiao_sock_ino_cmp(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+
+    if (x == y)
+        return 0;
+    return x < y ? -1 : 1;
+}
+
+static bool xiao_sock_is_owned(const struct xiao_sock_walk *walk, struct sock *sk)
+{
+    unsigned long ino;
+
+    /* Time-wait and request sockets have no file behind them */
+    if (!sk_fullsock(sk))
+        return false;
+
+    ino = sock_i_ino(sk);
+    return ino && bsearch(&ino, walk->owned, walk->nr_owned, sizeof(*walk->owned),
+                          xiao_sock_ino_cmp);
+}
+
+static void xiao_sock_fill_stats(struct xiao_socket_info *info, struct sock *sk, u8 protocol)
+{
+    const struct tcp_sock *tp;
+
+    info->fields |= XIAO_SOCK_FIELD_STATS;
+
+    if (protocol != IPPROTO_TCP) {
+        info->rx_queue = sk_rmem_alloc_get(sk);
+        info->tx_queue = sk_wmem_alloc_get(sk);
+        return;
+    }
+
+    if (info->state == TCP_LISTEN) {
+        info->rx_queue = READ_ONCE(sk->sk_ack_backlog);
+        info->tx_queue = READ_ONCE(sk->sk_max_ack_backlog);
+        return;
+    }
+
+    tp = tcp_sk(sk);
+    info->rtt_us = READ_ONCE(tp->srtt_us) >> 3;
+    info->rx_queue = max_t(int, READ_ONCE(tp->rcv_nxt) - READ_ONCE(tp->copied_seq), 0);
+    info->tx_queue = READ_ONCE(tp->write_seq) - READ_ONCE(tp->snd_una);
+}
+
+/* Called with the socket's hash bucket locked */
+static void xiao_sock_visit(struct xiao_sock_walk *walk, struct sock *sk, u8 protocol)
+{
+    const struct xiao_socket_query *query = walk->query;
+    struct xiao_socket_info *info;
+    u16 sport, dport;
+    u8 state;
+
+    if (!net_eq(sock_net(sk), walk->net))
+        return;
+
+    state = READ_ONCE(sk->sk_state);
+    if (state == TCP_NEW_SYN_RECV)
+        state = TCP_SYN_RECV;
+    if (query->states && !(query->states & (1U << state)))
+        return;
+
+    sport = sk->sk_num;
+    dport = ntohs(sk->sk_dport);
+    if (query->port && query->port != sport && query->port != dport)
+        return;
+
+    if (walk->owned && !xiao_sock_is_owned(walk, sk))
+        return;
+
+    /* One match past a full page is enough to report that more follow */
+    if (walk->count >= walk->max_out) {
+        walk->flags |= XIAO_SOCK_F_MORE;
+        return;
+    }
+
+    if (walk->idx++ < query->offset)
+        return;
+
+    info = &walk->out[walk->count++];
+    memset(info, 0, sizeof(*info));
+    info->family = sk->sk_family;
+    info->protocol = protocol;
+    info->state = state;
+    info->sport = sport;
+    info->dport = dport;
+
+    if (sk->sk_family == AF_INET) {
+        memcpy(info->saddr, &sk->sk_rcv_saddr, sizeof(sk->sk_rcv_saddr));
+        memcpy(info->daddr, &sk->sk_daddr, sizeof(sk->sk_daddr));
+    }
+#if IS_ENABLED(CONFIG_IPV6)
+    else if (sk->sk_family == AF_INET6) {
+        memcpy(info->saddr, &sk->sk_v6_rcv_saddr, sizeof(sk->sk_v6_rcv_saddr));
+        memcpy(info->daddr, &sk->sk_v6_daddr, sizeof(sk->sk_v6_daddr));
+    }
+#endif
+
+    /* Time-wait and request sockets only carry the common header */
+    if (!sk_fullsock(sk))
+        return;
+
+    info->uid = from_kuid_munged(current_user_ns(), sk->sk_uid);
+
+    if (query->fields & XIAO_SOCK_FIELD_STATS)
+        xiao_sock_fill_stats(info, sk, protocol);
+}
+
+static void xiao_sock_walk_tcp(struct xiao_sock_walk *walk)
+{
+    struct inet_hashinfo *hinfo = walk->net->ipv4.tcp_death_row.hashinfo;
+    struct inet_listen_hashbucket *ilb;
+    struct inet_ehash_bucket *head;
+    struct hlist_nulls_node *node;
+    spinlock_t *lock;
+    struct sock *sk;
+    u32 i;
+
+    for (i = 0; i <= hinfo->lhash2_mask; i++) {
+        ilb = &hinfo->lhash2[i];
+        if (hlist_nulls_empty(&ilb->nulls_head))
+            continue;
+
+        spin_lock(&ilb->lock);
+        sk_nulls_for_each(sk, node, &ilb->nulls_head)
+            xiao_sock_visit(walk, sk, IPPROTO_TCP);
+        spin_unlock(&ilb->lock);
+
+        if (walk->flags & XIAO_SOCK_F_MORE)
+            return;
+    }
+
+    for (i = 0; i <= hinfo->ehash_mask; i++) {
+        head = &hinfo->ehash[i];
+        if (hlist_nulls_empty(&head->chain))
+            continue;
+
+        lock = inet_ehash_lockp(hinfo, i);
+        spin_lock_bh(lock);
+        sk_nulls_for_each(sk, node, &head->chain)
+            xiao_sock_visit(walk, sk, IPPROTO_TCP);
+        spin_unlock_bh(lock);
+
+        if (walk->flags & XIAO_SOCK_F_MORE)
+            return;
+
+        cond_resched();
+    }
+}
+
+static void xiao_sock_walk_udp(struct xiao_sock_walk *walk)
+{
+    struct udp_table *table = walk->net->ipv4.udp_table;
+    struct udp_hslot *hslot;
+    struct sock *sk;
+    u32 i;
+
+    for (i = 0; i <= table->mask; i++) {
+        hslot = &table->hash[i];
+        if (hlist_empty(&hslot->head))
+            continue;
+
+        spin_lock_bh(&hslot->lock);
+        sk_for_each(sk, &hslot->head)
+            xiao_sock_visit(walk, sk, IPPROTO_UDP);
+        spin_unlock_bh(&hslot->lock);
+
+        if (walk->flags & XIAO_SOCK_F_MORE)
+            return;
+
+        cond_resched();
+    }
+}
+
+int xiao_get_sockets(struct net *net, const struct xiao_socket_query *query, void *buf, u32 size,
+                     u32 *data_len)
+{
+    struct xiao_socket_header *hdr = buf;
+    struct xiao_sock_walk walk = { .query = query, .net = net };
+    struct xiao_sock_collect collect = { .walk = &walk };
+    struct task_struct *task;
+    struct pid *spid;
+    u32 protocols;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    walk.out = (struct xiao_socket_info *)(hdr + 1);
+    walk.max_out = (size - sizeof(*hdr)) / sizeof(*walk.out);
+    if (query->max_count && query->max_count < walk.max_out)
+        walk.max_out = query->max_count;
+
+    if (query->pid) {
+        spid = find_get_pid(query->pid);
+        task = get_pid_task(spid, PIDTYPE_PID);
+        put_pid(spid);
+        if (!task)
+            return -ESRCH;
+
+        walk.owned = kmalloc_array(XIAO_SOCK_MAX_OWNED, sizeof(*walk.owned), GFP_KERNEL);
+        if (!walk.owned) {
+            put_task_struct(task);
+            return -ENOMEM;
+        }
+
+        task_lock(task);
+        if (task->files)
+            iterate_fd(task->files, 0, xiao_sock_collect_fd, &collect);
+        task_unlock(task);
+        put_task_struct(task);
+
+        sort(walk.owned, walk.nr_owned, sizeof(*walk.owned), xiao_sock_ino_cmp, NULL);
+    }
+
+    protocols = query->protocols ? query->protocols : XIAO_SOCK_PROTO_TCP | XIAO_SOCK_PROTO_UDP;
+
+    if (!walk.owned || walk.nr_owned) {
+        if (protocols & XIAO_SOCK_PROTO_TCP)
+            xiao_sock_walk_tcp(&walk);
+        if ((protocols & XIAO_SOCK_PROTO_UDP) && !(walk.flags & XIAO_SOCK_F_MORE))
+            xiao_sock_walk_udp(&walk);
+    }
+
+    kfree(walk.owned);
+
+    hdr->total = walk.idx;
+    hdr->count = walk.count;
+    hdr->flags = walk.flags;
+    hdr->reserved = 0;
+    *data_len = sizeof(*hdr) + walk.count * sizeof(struct xiao_socket_info);
+
+    return 0;
+}
+#else
+int xiao_get_sockets(struct net *net, const struct xiao_socket_query *query, void *buf, u32 size,
+                     u32 *data_len)
+{
+    return -EOPNOTSUPP;
+}
+#endif
+
+/*
+ * Link and address notifications. Notifier callbacks only merge the change
+ * into a per-interface pending slot; a delayed work item sends the coalesced
+ * batch to netlink multicast listeners once the burst has settled.
+ */
+static struct xiao_link_event xiao_notify_pending[XIAO_NET_MAX_IFACES];
+static u32 xiao_notify_count;
+static u32 xiao_notify_overflow;
+static u64 xiao_notify_sent;
+
+static void xiao_notify_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(xiao_notify_work, xiao_notify_work_fn);
+
+static void xiao_notify_queue(struct net_device *dev, u32 events)
+{
+    struct xiao_link_event *ev = NULL;
+    unsigned long irqflags;
+    u32 i;
+
+    if (!net_eq(dev_net(dev), &init_net))
+        return;
+
+    spin_lock_irqsave(&xiao_notify_lock, irqflags);
+
+    for (i = 0; i < xiao_notify_count; i++) {
+        if (xiao_notify_pending[i].ifindex == dev->ifindex) {
+            ev = &xiao_notify_pending[i];
+            break;
+        }
+    }
+
+    if (!ev && xiao_notify_count < XIAO_NET_MAX_IFACES) {
+        ev = &xiao_notify_pending[xiao_notify_count++];
+        memset(ev, 0, sizeof(*ev));
+        ev->ifindex = dev->ifindex;
+    }
+
+    if (ev) {
+        ev->timestamp = ktime_get_ns();
+        ev->events |= events;
+        ev->flags = dev_get_flags(dev);
+        ev->mtu = READ_ONCE(dev->mtu);
+        strscpy(ev->name, dev->name, sizeof(ev->name));
+    } else {
+        xiao_notify_overflow = 1;
+    }
+
+    spin_unlock_irqrestore(&xiao_notify_lock, irqflags);
+
+    queue_delayed_work(system_power_efficient_wq, &xiao_notify_work,
+                       msecs_to_jiffies(XIAO_NOTIFY_DELAY_MS));
+}
+
+static void xiao_notify_work_fn(struct work_struct *work)
+{
+    struct xiao_link_event_batch *batch;
+    unsigned long irqflags;
+    u32 len;
+
+    len = sizeof(*batch) + sizeof(xiao_notify_pending);
+    batch = kzalloc(len, GFP_KERNEL);
+    if (!batch)
+        return;
+
+    spin_lock_irqsave(&xiao_notify_lock, irqflags);
+    batch->count = xiao_notify_count;
+    batch->overflow = xiao_notify_overflow;
+    memcpy(batch->events, xiao_notify_pending, batch->count * sizeof(batch->events[0]));
+    xiao_notify_count = 0;
+    xiao_notify_overflow = 0;
+    spin_unlock_irqrestore(&xiao_notify_lock, irqflags);
+
+    if (batch->count || batch->overflow) {
+        len = sizeof(*batch) + batch->count * sizeof(batch->events[0]);
+        if (xiao_ipc_broadcast(XIAO_NLMSG_LINK_EVENT, batch, len) == 0)
+            xiao_notify_sent++;
+    }
+
+    kfree(batch);
+}
+
+/* Drops a pending batch so it cannot race the netlink socket going away */
+void xiao_net_notify_cancel(void)
+{
+    cancel_delayed_work_sync(&xiao_notify_work);
+}
+
+static int xiao_netdev_event(struct notifier_block *nb, unsigned long event, void *ptr)
+{
+    struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+    u32 events;
+
+    switch (event) {
+    case NETDEV_REGISTER:
+        events = XIAO_LINK_EV_REGISTER;
+        break;
+    case NETDEV_UNREGISTER:
+        events = XIAO_LINK_EV_UNREGISTER;
+        break;
+    case NETDEV_UP:
+        events = XIAO_LINK_EV_UP;
+        break;
+    case NETDEV_DOWN:
+        events = XIAO_LINK_EV_DOWN;
+        break;
+    case NETDEV_CHANGE:
+        events = XIAO_LINK_EV_CARRIER;
+        break;
+    case NETDEV_CHANGEMTU:
+        events = XIAO_LINK_EV_MTU;
+        break;
+    case NETDEV_CHANGENAME:
+        events = XIAO_LINK_EV_RENAME;
+        break;
+    default:
+        return NOTIFY_DONE;
+    }
+
+    xiao_notify_queue(dev, events);
+    return NOTIFY_DONE;
+}
+
+static int xiao_inetaddr_event(struct notifier_block *nb, unsigned long event, void *ptr)
+{
+    struct in_ifaddr *ifa = ptr;
+
+    if (event == NETDEV_UP)
+        xiao_notify_queue(ifa->ifa_dev->dev, XIAO_LINK_EV_ADDR_ADD);
+    else if (event == NETDEV_DOWN)
+        xiao_notify_queue(ifa->ifa_dev->dev, XIAO_LINK_EV_ADDR_DEL);
+
+    return NOTIFY_DONE;
+}
+
+#if IS_ENABLED(CONFIG_IPV6)
+static int xiao_inet6addr_event(struct notifier_block *nb, unsigned long event, void *ptr)
+{
+    struct inet6_ifaddr *ifp = ptr;
+
+    if (event == NETDEV_UP)
+        xiao_notify_queue(ifp->idev->dev, XIAO_LINK_EV_ADDR_ADD);
+    else if (event == NETDEV_DOWN)
+        xiao_notify_queue(ifp->idev->dev, XIAO_LINK_EV_ADDR_DEL);
+
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block xiao_inet6addr_nb = {
+    .notifier_call = xiao_inet6addr_event,
+};
+#endif
+
+static struct notifier_block xiao_netdev_nb = {
+    .notifier_call = xiao_netdev_event,
+};
+
+static struct notifier_block xiao_inetaddr_nb = {
+    .notifier_call = xiao_inetaddr_event,
+};
+
 static int xiao_net_proc_show(struct seq_file *m, void *v)
 {
+    struct rtnl_link_stats64 stats;
     struct net_device *dev;
     struct in_device *in_dev;
+    struct in_ifaddr *ifa;
 
     seq_printf(m, "xiao network bridge\n");
     seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
-    seq_printf(m, "operations: get_net_config, set_net_config\n");
+    seq_printf(m, "operations: get_net_config, set_net_config, get_net_rates, get_net_addrs,\n");
+    seq_printf(m, "            set_link_config_batch, get_sockets\n");
+    seq_printf(m, "notifications: %llu batches sent\n", READ_ONCE(xiao_notify_sent));
 
     seq_printf(m, "\n--- Network Interfaces ---\n");
 
-    rtnl_lock();
+    rcu_read_lock();
+
+    for_each_netdev_rcu(&init_net, dev) {
+        dev_get_stats(dev, &stats);
 
-    for_each_netdev(&init_net, dev) {
         seq_printf(m, "\nInterface: %s\n", dev->name);
         seq_printf(m, "  MTU: %d\n", dev->mtu);
         seq_printf(m, "  Flags: 0x%08x\n", dev->flags);
         seq_printf(m, "  MAC: %pM\n", dev->dev_addr);
         seq_printf(m, "  RX: %llu bytes, %llu packets\n",
-                   dev->stats.rx_bytes, dev->stats.rx_packets);
+                   stats.rx_bytes, stats.rx_packets);
         seq_printf(m, "  TX: %llu bytes, %llu packets\n",
-                   dev->stats.tx_bytes, dev->stats.tx_packets);
+                   stats.tx_bytes, stats.tx_packets);
 
-        in_dev = dev->ip_ptr;
-        if (in_dev && in_dev->ifa_list) {
-            seq_printf(m, "  IP: %pI4\n", &in_dev->ifa_list->ifa_address);
-            seq_printf(m, "  Netmask: %pI4\n", &in_dev->ifa_list->ifa_mask);
+        in_dev = __in_dev_get_rcu(dev);
+        ifa = in_dev ? rcu_dereference(in_dev->ifa_list) : NULL;
+        if (ifa) {
+            seq_printf(m, "  IP: %pI4\n", &ifa->ifa_address);
+            seq_printf(m, "  Netmask: %pI4\n", &ifa->ifa_mask);
         }
     }
 
-    rtnl_unlock();
+    rcu_read_unlock();
 
     return 0;
 }
@@ -179,17 +1102,53 @@ static struct proc_dir_entry *xiao_net_proc_entry;
 
 int __init xiao_net_init(void)
 {
+    int ret;
+
     xiao_net_proc_entry = proc_create("xiao_net", 0444, NULL, &xiao_net_proc_fops);
     if (!xiao_net_proc_entry) {
         pr_err("xiao_net: failed to create proc entry\n");
         return -ENOMEM;
     }
+
+    ret = register_netdevice_notifier(&xiao_netdev_nb);
+    if (ret)
+        goto fail_netdev;
+
+    ret = register_inetaddr_notifier(&xiao_inetaddr_nb);
+    if (ret)
+        goto fail_inetaddr;
+
+#if IS_ENABLED(CONFIG_IPV6)
+    ret = register_inet6addr_notifier(&xiao_inet6addr_nb);
+    if (ret)
+        goto fail_inet6addr;
+#endif
+
     pr_info("xiao_net: network subsystem initialized\n");
     return 0;
+
+#if IS_ENABLED(CONFIG_IPV6)
+fail_inet6addr:
+    unregister_inetaddr_notifier(&xiao_inetaddr_nb);
+#endif
+fail_inetaddr:
+    unregister_netdevice_notifier(&xiao_netdev_nb);
+fail_netdev:
+    cancel_delayed_work_sync(&xiao_notify_work);
+    pr_err("xiao_net: failed to register notifiers\n");
+    remove_proc_entry("xiao_net", NULL);
+    return ret;
 }
 
 void __exit xiao_net_exit(void)
 {
+#if IS_ENABLED(CONFIG_IPV6)
+    unregister_inet6addr_notifier(&xiao_inet6addr_nb);
+#endif
+    unregister_inetaddr_notifier(&xiao_inetaddr_nb);
+    unregister_netdevice_notifier(&xiao_netdev_nb);
+    cancel_delayed_work_sync(&xiao_notify_work);
+
     if (xiao_net_proc_entry)
         remove_proc_entry("xiao_net", NULL);
     pr_info("xiao_net: network subsystem cleanup complete\n");
@@ -1,6 +1,57 @@
 #include "xiao_syscall.h"
 
 static DEFINE_MUTEX(xiao_proc_lock);
+/*
+ * Handles belong to the opening process, identified by tgid and start time
+ * so a recycled tgid never inherits them. Each owner has a quota and its
+ * handles are dropped when its thread group exits.
+ */
+static DEFINE_SPINLOCK(xiao_handle_lock);
+static DEFINE_IDR(xiao_handle_idr);
+static DEFINE_HASHTABLE(xiao_handle_owners, XIAO_HANDLE_OWNER_BITS);
+static u32 xiao_handle_nr_owners;
+static struct tracepoint *xiao_handle_tp_exit;
+
+struct xiao_proc_handle {
+    struct pid *pid;
+    pid_t owner;
+    u64 owner_start;
+};
+
+struct xiao_handle_owner {
+    struct hlist_node node;
+    pid_t tgid;
+    u64 start_time;
+    u32 count;
+};
+
+static void xiao_fill_process_info(struct task_struct *task, struct xiao_process_info *info)
+{
+    struct mm_struct *mm;
+
+    memset(info, 0, sizeof(*info));
+    info->pid = task->pid;
+    info->ppid = task->real_parent ? task->real_parent->pid : 0;
+    info->uid = from_kuid_munged(current_user_ns(), task_uid(task));
+    info->gid = from_kgid_munged(current_user_ns(), task_gid(task));
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+    info->state = READ_ONCE(task->__state);
+#else
+    info->state = task->state;
+#endif
+    info->state_char = task_state_to_char(task);
+    info->utime = task->utime;
+    info->stime = task->stime;
+
+    mm = get_task_mm(task);
+    if (mm) {
+        info->vmsize = mm->total_vm;
+        info->vmrss = get_mm_rss(mm);
+        mmput(mm);
+    }
+
+    strncpy(info->comm, task->comm, TASK_COMM_LEN - 1);
+}
 
 int xiao_get_processes(struct xiao_process_info __user *buf, u32 max_count, u32 __user *count)
 {
@@ -12,11 +63,7 @@ int xiao_get_processes(struct xiao_process_info __user *buf, u32 max_count, u32
     if (!buf || !count)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_PROC_LIST);
-    if (ret)
-        return ret;
-
-    mutex_lock(&xiao_proc_lock);
+    xiao_mutex_lock_traced(&xiao_proc_lock, XIAO_LOCK_PROC);
 
     for_each_process(task) {
         if (count_val >= max_count)
@@ -25,18 +72,7 @@ int xiao_get_processes(struct xiao_process_info __user *buf, u32 max_count, u32
         if (task->exit_state == EXIT_DEAD)
             continue;
 
-        memset(&info, 0, sizeof(info));
-        info.pid = task->pid;
-        info.ppid = task->real_parent ? task->real_parent->pid : 0;
-        info.uid = from_kuid_munged(current_user_ns(), task_uid(task));
-        info.gid = from_kgid_munged(current_user_ns(), task_gid(task));
-        info.state = task->state;
-        info.state_char = task_state_to_char(task);
-        info.utime = task->utime;
-        info.stime = task->stime;
-        info.vmsize = task->mm ? task->mm->total_vm : 0;
-        info.vmrss = task->mm ? task->mm->rss : 0;
-        strncpy(info.comm, task->comm, TASK_COMM_LEN - 1);
+        xiao_fill_process_info(task, &info);
 
         if (copy_to_user(&buf[count_val], &info, sizeof(info))) {
             ret = -EFAULT;
@@ -58,11 +94,7 @@ int xiao_kill_process(u32 pid, int sig)
     struct task_struct *task;
     int ret;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_PROC_KILL);
-    if (ret)
-        return ret;
-
-    mutex_lock(&xiao_proc_lock);
+    xiao_mutex_lock_traced(&xiao_proc_lock, XIAO_LOCK_PROC);
 
     task = pid_task(find_vpid(pid), PIDTYPE_PID);
     if (!task) {
@@ -91,11 +123,7 @@ int xiao_get_process_info(u32 pid, struct xiao_process_info __user *info)
     if (!info)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_PROC_LIST);
-    if (ret)
-        return ret;
-
-    mutex_lock(&xiao_proc_lock);
+    xiao_mutex_lock_traced(&xiao_proc_lock, XIAO_LOCK_PROC);
 
     task = pid_task(find_vpid(pid), PIDTYPE_PID);
     if (!task) {
@@ -103,18 +131,7 @@ int xiao_get_process_info(u32 pid, struct xiao_process_info __user *info)
         goto out;
     }
 
-    memset(&pinfo, 0, sizeof(pinfo));
-    pinfo.pid = task->pid;
-    pinfo.ppid = task->real_parent ? task->real_parent->pid : 0;
-    pinfo.uid = from_kuid_munged(current_user_ns(), task_uid(task));
-    pinfo.gid = from_kgid_munged(current_user_ns(), task_gid(task));
-    pinfo.state = task->state;
-    pinfo.state_char = task_state_to_char(task);
-    pinfo.utime = task->utime;
-    pinfo.stime = task->stime;
-    pinfo.vmsize = task->mm ? task->mm->total_vm : 0;
-    pinfo.vmrss = task->mm ? task->mm->rss : 0;
-    strncpy(pinfo.comm, task->comm, TASK_COMM_LEN - 1);
+    xiao_fill_process_info(task, &pinfo);
 
     if (copy_to_user(info, &pinfo, sizeof(pinfo)))
         ret = -EFAULT;
@@ -126,6 +143,465 @@ out:
     return ret;
 }
 
+/* Caller holds xiao_handle_lock */
+static struct xiao_handle_owner *xiao_handle_owner_find(pid_t tgid, u64 start_time)
+{
+    struct xiao_handle_owner *owner;
+
+    hash_for_each_possible(xiao_handle_owners, owner, node, tgid) {
+        if (owner->tgid == tgid && owner->start_time == start_time)
+            return owner;
+    }
+
+    return NULL;
+}
+
+/* Caller holds xiao_handle_lock */
+static void xiao_handle_owner_put(struct xiao_handle_owner *owner)
+{
+    if (--owner->count)
+        return;
+
+    hash_del(&owner->node);
+    WRITE_ONCE(xiao_handle_nr_owners, xiao_handle_nr_owners - 1);
+    kfree(owner);
+}
+
+static inline bool xiao_handle_owned(const struct xiao_proc_handle *h)
+{
+    return h->owner == current->tgid && h->owner_start == current->group_leader->start_time;
+}
+
+static XIAO_EXIT_PROBE(xiao_handle_exit_probe)
+{
+    struct xiao_handle_owner *owner;
+    struct xiao_proc_handle *h;
+    u64 start_time;
+    int id;
+
+    if (!READ_ONCE(xiao_handle_nr_owners))
+        return;
+
+    /* Only the last thread of the group drops the handles */
+    if (atomic_read(&task->signal->live))
+        return;
+
+    start_time = task->group_leader->start_time;
+
+    spin_lock(&xiao_handle_lock);
+    owner = xiao_handle_owner_find(task->tgid, start_time);
+    if (owner) {
+        idr_for_each_entry(&xiao_handle_idr, h, id) {
+            if (h->owner != task->tgid || h->owner_start != start_time)
+                continue;
+            idr_remove(&xiao_handle_idr, id);
+            put_pid(h->pid);
+            kfree(h);
+        }
+        hash_del(&owner->node);
+        WRITE_ONCE(xiao_handle_nr_owners, xiao_handle_nr_owners - 1);
+        kfree(owner);
+    }
+    spin_unlock(&xiao_handle_lock);
+}
+
+int xiao_open_process(u32 pid, u32 *handle)
+{
+    struct xiao_handle_owner *owner, *fresh;
+    struct xiao_proc_handle *h;
+    struct task_struct *task;
+    struct pid *spid;
+    int id;
+
+    if (!handle)
+        return -EINVAL;
+
+    spid = find_get_pid(pid);
+    if (!spid)
+        return -ESRCH;
+
+    rcu_read_lock();
+    task = pid_task(spid, PIDTYPE_TGID);
+    rcu_read_unlock();
+    if (!task) {
+        put_pid(spid);
+        return -ESRCH;
+    }
+
+    h = kmalloc(sizeof(*h), GFP_KERNEL);
+    fresh = kzalloc(sizeof(*fresh), GFP_KERNEL);
+    if (!h || !fresh) {
+        put_pid(spid);
+        kfree(h);
+        kfree(fresh);
+        return -ENOMEM;
+    }
+
+    h->pid = spid;
+    h->owner = current->tgid;
+    h->owner_start = current->group_leader->start_time;
+
+    idr_preload(GFP_KERNEL);
+    spin_lock(&xiao_handle_lock);
+
+    owner = xiao_handle_owner_find(h->owner, h->owner_start);
+    if (owner && owner->count >= XIAO_MAX_HANDLES_PER_OWNER) {
+        id = -ENOSPC;
+    } else {
+        id = idr_alloc(&xiao_handle_idr, h, 1, XIAO_MAX_HANDLES + 1, GFP_NOWAIT);
+        if (id > 0 && !owner) {
+            owner = fresh;
+            owner->tgid = h->owner;
+            owner->start_time = h->owner_start;
+            hash_add(xiao_handle_owners, &owner->node, owner->tgid);
+            WRITE_ONCE(xiao_handle_nr_owners, xiao_handle_nr_owners + 1);
+            fresh = NULL;
+        }
+        if (id > 0)
+            owner->count++;
+    }
+
+    spin_unlock(&xiao_handle_lock);
+    idr_preload_end();
+
+    kfree(fresh);
+
+    if (id < 0) {
+        put_pid(spid);
+        kfree(h);
+        return id == -ENOSPC ? -EMFILE : id;
+    }
+
+    *handle = id;
+    return 0;
+}
+
+int xiao_close_process(u32 handle)
+{
+    struct xiao_proc_handle *h;
+
+    spin_lock(&xiao_handle_lock);
+    h = idr_find(&xiao_handle_idr, handle);
+    if (!h || !xiao_handle_owned(h)) {
+        spin_unlock(&xiao_handle_lock);
+        return -EBADF;
+    }
+    idr_remove(&xiao_handle_idr, handle);
+    xiao_handle_owner_put(xiao_handle_owner_find(h->owner, h->owner_start));
+    spin_unlock(&xiao_handle_lock);
+
+    put_pid(h->pid);
+    kfree(h);
+    return 0;
+}
+
+static struct pid *xiao_handle_get_pid(u32 handle)
+{
+    struct xiao_proc_handle *h;
+    struct pid *pid = NULL;
+
+    spin_lock(&xiao_handle_lock);
+    h = idr_find(&xiao_handle_idr, handle);
+    if (h && xiao_handle_owned(h))
+        pid = get_pid(h->pid);
+    spin_unlock(&xiao_handle_lock);
+
+    return pid;
+}
+
+int xiao_handle_get_info(u32 handle, struct xiao_process_info *info)
+{
+    struct task_struct *task;
+    struct pid *pid;
+
+    if (!info)
+        return -EINVAL;
+
+    pid = xiao_handle_get_pid(handle);
+    if (!pid)
+        return -EBADF;
+
+    task = get_pid_task(pid, PIDTYPE_TGID);
+    put_pid(pid);
+    if (!task)
+        return -ESRCH;
+
+    xiao_fill_process_info(task, info);
+    put_task_struct(task);
+
+    return 0;
+}
+
+int xiao_handle_signal(u32 handle, int sig)
+{
+    struct task_struct *task;
+    struct pid *pid;
+    int ret = 0;
+
+    if (!valid_signal(sig))
+        return -EINVAL;
+
+    pid = xiao_handle_get_pid(handle);
+    if (!pid)
+        return -EBADF;
+
+    rcu_read_lock();
+    task = pid_task(pid, PIDTYPE_TGID);
+    if (!task)
+        ret = -ESRCH;
+    else if (task->signal->flags & SIGNAL_UNKILLABLE)
+        ret = -EPERM;
+    rcu_read_unlock();
+
+    if (!ret)
+        ret = kill_pid(pid, sig, 1);
+
+    put_pid(pid);
+    return ret;
+}
+
+int xiao_handle_wait(u32 handle, u32 timeout_ms)
+{
+    struct pid *pid;
+    long ret;
+
+    pid = xiao_handle_get_pid(handle);
+    if (!pid)
+        return -EBADF;
+
+    /* callers drop xiao_ipc_lock first; the cap bounds a single request */
+    timeout_ms = min_t(u32, timeout_ms, XIAO_HANDLE_WAIT_MAX_MS);
+
+    if (thread_group_exited(pid))
+        ret = 1;
+    else if (timeout_ms)
+        ret = wait_event_interruptible_timeout(pid->wait_pidfd,
+                                               thread_group_exited(pid),
+                                               msecs_to_jiffies(timeout_ms));
+    else
+        ret = 0;
+
+    put_pid(pid);
+
+    if (ret < 0)
+        return ret;
+    return ret ? 0 : -ETIMEDOUT;
+}
+
+static int xiao_thread_cmp_cpu(const void *a, const void *b)
+{
+    const struct xiao_thread_info *x = a;
+    const struct xiao_thread_info *y = b;
+
+    if (x->cpu_time == y->cpu_time)
+        return 0;
+    return x->cpu_time < y->cpu_time ? 1 : -1;
+}
+
+int xiao_get_threads(const struct xiao_thread_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_thread_info *threads;
+    struct xiao_thread_info *ti;
+    struct task_struct *task;
+    struct task_struct *t;
+    struct pid *spid;
+    u32 nr, n = 0;
+    u32 max_out, count;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    spid = find_get_pid(query->pid);
+    task = get_pid_task(spid, PIDTYPE_PID);
+    put_pid(spid);
+    if (!task)
+        return -ESRCH;
+
+    nr = get_nr_threads(task) + XIAO_THREAD_SLACK;
+    threads = kvmalloc_array(nr, sizeof(*threads), GFP_KERNEL);
+    if (!threads) {
+        put_task_struct(task);
+        return -ENOMEM;
+    }
+
+    rcu_read_lock();
+    for_each_thread(task, t) {
+        if (n >= nr)
+            break;
+
+        ti = &threads[n++];
+        memset(ti, 0, sizeof(*ti));
+        ti->cpu_time = t->se.sum_exec_runtime;
+        ti->tid = task_pid_vnr(t);
+        ti->last_cpu = task_cpu(t);
+        ti->prio = t->prio - MAX_RT_PRIO;
+        ti->nice = task_nice(t);
+        ti->state = task_state_to_char(t);
+        strncpy(ti->comm, t->comm, TASK_COMM_LEN - 1);
+    }
+    rcu_read_unlock();
+
+    put_task_struct(task);
+
+    if (query->sort == XIAO_THREAD_SORT_CPU)
+        sort(threads, n, sizeof(*threads), xiao_thread_cmp_cpu, NULL);
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*threads);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
+
+    count = query->offset < n ? min(n - query->offset, max_out) : 0;
+
+    hdr->total = n;
+    hdr->count = count;
+    if (count)
+        memcpy(hdr + 1, &threads[query->offset], count * sizeof(*threads));
+
+    *data_len = sizeof(*hdr) + count * sizeof(*threads);
+
+    kvfree(threads);
+    return 0;
+}
+
+static u64 xiao_smaps_field(const char *buf, const char *key)
+{
+    const char *p;
+    u64 val = 0;
+
+    p = strstr(buf, key);
+    if (p && sscanf(p + strlen(key), "%llu", &val) == 1)
+        return val * 1024;
+
+    return 0;
+}
+
+static int xiao_read_smaps_rollup(struct task_struct *task, u64 *pss, u64 *uss)
+{
+    char path[64];
+    char *buf;
+    ssize_t len;
+
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", task_tgid_vnr(task));
+
+    buf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+    if (!buf)
+        return -ENOMEM;
+
+    len = xiao_kernel_read_file(path, buf, PAGE_SIZE);
+    if (len < 0) {
+        kfree(buf);
+        return len;
+    }
+
+    *pss = xiao_smaps_field(buf, "\nPss:");
+    *uss = xiao_smaps_field(buf, "\nPrivate_Clean:") +
+           xiao_smaps_field(buf, "\nPrivate_Dirty:");
+
+    kfree(buf);
+    return 0;
+}
+
+static u32 xiao_count_open_fds(struct task_struct *task)
+{
+    struct files_struct *files;
+    struct fdtable *fdt;
+    u32 nr = 0;
+
+    task_lock(task);
+    files = task->files;
+    if (files) {
+        rcu_read_lock();
+        fdt = files_fdtable(files);
+        nr = bitmap_weight(fdt->open_fds, fdt->max_fds);
+        rcu_read_unlock();
+    }
+    task_unlock(task);
+
+    return nr;
+}
+
+int xiao_get_process_info_ex(u32 pid, u32 fields, struct xiao_process_info_ex *info)
+{
+    struct task_struct *task;
+    struct task_struct *t;
+    struct pid *spid;
+    int cpu;
+
+    if (!info)
+        return -EINVAL;
+
+    spid = find_get_pid(pid);
+    task = get_pid_task(spid, PIDTYPE_PID);
+    put_pid(spid);
+    if (!task)
+        return -ESRCH;
+
+    memset(info, 0, sizeof(*info));
+    xiao_fill_process_info(task, &info->base);
+
+    if (fields & XIAO_PROC_FIELD_THREADS) {
+        info->nr_threads = get_nr_threads(task);
+        info->fields |= XIAO_PROC_FIELD_THREADS;
+    }
+
+    if (fields & XIAO_PROC_FIELD_CTXSW) {
+        info->nvcsw = task->signal->nvcsw;
+        info->nivcsw = task->signal->nivcsw;
+        rcu_read_lock();
+        for_each_thread(task, t) {
+            info->nvcsw += t->nvcsw;
+            info->nivcsw += t->nivcsw;
+        }
+        rcu_read_unlock();
+        info->fields |= XIAO_PROC_FIELD_CTXSW;
+    }
+
+#ifdef CONFIG_TASK_IO_ACCOUNTING
+    if (fields & XIAO_PROC_FIELD_IO) {
+        struct task_io_accounting acct = task->signal->ioac;
+
+        rcu_read_lock();
+        for_each_thread(task, t)
+            task_io_accounting_add(&acct, &t->ioac);
+        rcu_read_unlock();
+
+        info->read_bytes = acct.read_bytes;
+        info->write_bytes = acct.write_bytes;
+        info->fields |= XIAO_PROC_FIELD_IO;
+    }
+#endif
+
+    if (fields & XIAO_PROC_FIELD_FDS) {
+        info->nr_fds = xiao_count_open_fds(task);
+        info->fields |= XIAO_PROC_FIELD_FDS;
+    }
+
+    if (fields & XIAO_PROC_FIELD_PSS) {
+        if (xiao_read_smaps_rollup(task, &info->pss, &info->uss) == 0)
+            info->fields |= XIAO_PROC_FIELD_PSS;
+    }
+
+#ifdef CONFIG_CGROUPS
+    if (fields & XIAO_PROC_FIELD_CGROUP) {
+        if (task_cgroup_path(task, info->cgroup, sizeof(info->cgroup)) >= 0)
+            info->fields |= XIAO_PROC_FIELD_CGROUP;
+    }
+#endif
+
+    if (fields & XIAO_PROC_FIELD_AFFINITY) {
+        for_each_cpu(cpu, task->cpus_ptr) {
+            if (cpu >= XIAO_AFFINITY_WORDS * 64)
+                break;
+            info->cpus_allowed[cpu / 64] |= 1ULL << (cpu % 64);
+        }
+        info->fields |= XIAO_PROC_FIELD_AFFINITY;
+    }
+
+    put_task_struct(task);
+    return 0;
+}
+
 static int xiao_proc_proc_show(struct seq_file *m, void *v)
 {
     struct task_struct *task;
@@ -133,7 +609,9 @@ static int xiao_proc_proc_show(struct seq_file *m, void *v)
 
     seq_printf(m, "xiao process bridge\n");
     seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
-    seq_printf(m, "operations: get_processes, kill_process, get_process_info\n");
+    seq_printf(m, "operations: get_processes, kill_process, get_process_info, get_process_info_ex,\n");
+    seq_printf(m, "            open_process, close_process, handle_info, handle_signal, handle_wait,\n");
+    seq_printf(m, "            get_threads\n");
 
     seq_printf(m, "\n--- Process List (PID | PPID | UID | State | Command) ---\n");
 
@@ -184,13 +662,41 @@ int __init xiao_proc_init(void)
         pr_err("xiao_proc: failed to create proc entry\n");
         return -ENOMEM;
     }
+
+    xiao_handle_tp_exit = xiao_find_tracepoint("sched_process_exit");
+    if (!xiao_handle_tp_exit ||
+        tracepoint_probe_register(xiao_handle_tp_exit, xiao_handle_exit_probe, NULL)) {
+        pr_warn("xiao_proc: exit tracepoint unavailable, handles kept until closed\n");
+        xiao_handle_tp_exit = NULL;
+    }
     pr_info("xiao_proc: process management subsystem initialized\n");
     return 0;
 }
 
 void __exit xiao_proc_exit(void)
 {
+    struct xiao_handle_owner *owner;
+    struct xiao_proc_handle *h;
+    struct hlist_node *tmp;
+    int id, bkt;
+
     if (xiao_proc_proc_entry)
         remove_proc_entry("xiao_proc", NULL);
+
+    if (xiao_handle_tp_exit) {
+        tracepoint_probe_unregister(xiao_handle_tp_exit, xiao_handle_exit_probe, NULL);
+        tracepoint_synchronize_unregister();
+    }
+
+    hash_for_each_safe(xiao_handle_owners, bkt, tmp, owner, node) {
+        hash_del(&owner->node);
+        kfree(owner);
+    }
+
+    idr_for_each_entry(&xiao_handle_idr, h, id) {
+        put_pid(h->pid);
+        kfree(h);
+    }
+    idr_destroy(&xiao_handle_idr);
     pr_info("xiao_proc: process management subsystem cleanup complete\n");
 }
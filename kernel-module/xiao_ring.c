@@ -0,0 +1,272 @@
+#include "xiao_syscall.h"
+
+/*
+ * Per-CPU single-producer/single-consumer record rings. Producers run on
+ * the local CPU with preemption disabled and never take a lock; readers
+ * are serialized by set->read_lock and drain every CPU in turn.
+ */
+
+int xiao_ring_init(struct xiao_ring_set *set, u32 nr_records, u32 rec_size)
+{
+    struct xiao_ring *ring;
+    int cpu;
+
+    if (!nr_records || !is_power_of_2(nr_records) || !rec_size)
+        return -EINVAL;
+
+    set->nr_records = nr_records;
+    set->rec_size = rec_size;
+    mutex_init(&set->read_lock);
+
+    set->cpus = alloc_percpu(struct xiao_ring);
+    if (!set->cpus)
+        return -ENOMEM;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+        ring->buf = kvzalloc_node((size_t)nr_records * rec_size, GFP_KERNEL,
+                                  cpu_to_node(cpu));
+        if (!ring->buf) {
+            xiao_ring_free(set);
+            return -ENOMEM;
+        }
+    }
+
+    return 0;
+}
+
+void xiao_ring_free(struct xiao_ring_set *set)
+{
+    int cpu;
+
+    if (!set->cpus)
+        return;
+
+    for_each_possible_cpu(cpu)
+        kvfree(per_cpu_ptr(set->cpus, cpu)->buf);
+
+    free_percpu(set->cpus);
+    set->cpus = NULL;
+}
+
+bool xiao_ring_write(struct xiao_ring_set *set, const void *rec)
+{
+    struct xiao_ring *ring;
+    u32 head, tail;
+    bool ret = false;
+
+    ring = get_cpu_ptr(set->cpus);
+
+    head = ring->head;
+    tail = smp_load_acquire(&ring->tail);
+
+    if (head - tail < set->nr_records) {
+        memcpy(ring->buf + (size_t)(head & (set->nr_records - 1)) * set->rec_size,
+               rec, set->rec_size);
+        smp_store_release(&ring->head, head + 1);
+        ret = true;
+    } else {
+        WRITE_ONCE(ring->dropped, ring->dropped + 1);
+    }
+
+    put_cpu_ptr(set->cpus);
+    return ret;
+}
+
+u32 xiao_ring_drain(struct xiao_ring_set *set, void *buf, u32 max_records, u32 *dropped)
+{
+    struct xiao_ring *ring;
+    u32 head, tail, seen;
+    u32 count = 0;
+    u32 lost = 0;
+    int cpu;
+
+    mutex_lock(&set->read_lock);
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+
+        tail = ring->tail;
+        head = smp_load_acquire(&ring->head);
+
+        while (tail != head && count < max_records) {
+            memcpy(buf + (size_t)count * set->rec_size,
+                   ring->buf + (size_t)(tail & (set->nr_records - 1)) * set->rec_size,
+                   set->rec_size);
+            tail++;
+            count++;
+        }
+
+        smp_store_release(&ring->tail, tail);
+
+        seen = READ_ONCE(ring->dropped);
+        lost += seen - ring->dropped_seen;
+        ring->dropped_seen = seen;
+    }
+
+    mutex_unlock(&set->read_lock);
+
+    if (dropped)
+        *dropped = lost;
+
+    return count;
+}
+
+u32 xiao_ring_pending(struct xiao_ring_set *set)
+{
+    struct xiao_ring *ring;
+    u32 pending = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+        pending += READ_ONCE(ring->head) - READ_ONCE(ring->tail);
+    }
+
+    return pending;
+}
+
+/*
+ * Broadcast rings: per-CPU overwriting rings read by any number of
+ * consumers, each with its own per-CPU cursor. The producer never waits
+ * for readers; every slot carries the sequence number of the record in it
+ * so a reader that races with an overwrite notices and counts the record
+ * as lost instead of returning torn data.
+ */
+
+int xiao_bcast_init(struct xiao_bcast_set *set, u32 nr_records, u32 rec_size)
+{
+    struct xiao_bcast_ring *ring;
+    int cpu;
+
+    if (!nr_records || !is_power_of_2(nr_records) || !rec_size)
+        return -EINVAL;
+
+    set->nr_records = nr_records;
+    set->rec_size = rec_size;
+
+    set->cpus = alloc_percpu(struct xiao_bcast_ring);
+    if (!set->cpus)
+        return -ENOMEM;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+        ring->seq = kvzalloc_node((size_t)nr_records * sizeof(*ring->seq), GFP_KERNEL,
+                                  cpu_to_node(cpu));
+        ring->buf = kvzalloc_node((size_t)nr_records * rec_size, GFP_KERNEL,
+                                  cpu_to_node(cpu));
+        if (!ring->seq || !ring->buf) {
+            xiao_bcast_free(set);
+            return -ENOMEM;
+        }
+    }
+
+    return 0;
+}
+
+void xiao_bcast_free(struct xiao_bcast_set *set)
+{
+    struct xiao_bcast_ring *ring;
+    int cpu;
+
+    if (!set->cpus)
+        return;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+        kvfree(ring->seq);
+        kvfree(ring->buf);
+    }
+
+    free_percpu(set->cpus);
+    set->cpus = NULL;
+}
+
+void xiao_bcast_write(struct xiao_bcast_set *set, const void *rec)
+{
+    struct xiao_bcast_ring *ring;
+    unsigned long head;
+    u32 slot;
+
+    ring = get_cpu_ptr(set->cpus);
+
+    head = ring->head;
+    slot = head & (set->nr_records - 1);
+
+    WRITE_ONCE(ring->seq[slot], 0);
+    smp_wmb();
+    memcpy(ring->buf + (size_t)slot * set->rec_size, rec, set->rec_size);
+    smp_wmb();
+    WRITE_ONCE(ring->seq[slot], head + 1);
+    smp_store_release(&ring->head, head + 1);
+
+    put_cpu_ptr(set->cpus);
+}
+
+/* A new cursor starts at the current head, so it only sees later records */
+unsigned long *xiao_bcast_cursor_alloc(struct xiao_bcast_set *set)
+{
+    unsigned long *cursor;
+    int cpu;
+
+    cursor = kcalloc(nr_cpu_ids, sizeof(*cursor), GFP_KERNEL);
+    if (!cursor)
+        return NULL;
+
+    for_each_possible_cpu(cpu)
+        cursor[cpu] = smp_load_acquire(&per_cpu_ptr(set->cpus, cpu)->head);
+
+    return cursor;
+}
+
+/* Caller serializes reads through the same cursor */
+u32 xiao_bcast_read(struct xiao_bcast_set *set, unsigned long *cursor, void *buf,
+                    u32 max_records, u32 *dropped)
+{
+    struct xiao_bcast_ring *ring;
+    unsigned long head, pos;
+    void *out;
+    u32 count = 0;
+    u32 lost = 0;
+    u32 slot;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(set->cpus, cpu);
+
+        head = smp_load_acquire(&ring->head);
+        pos = cursor[cpu];
+
+        if (head - pos > set->nr_records) {
+            lost += head - pos - set->nr_records;
+            pos = head - set->nr_records;
+        }
+
+        while (pos != head && count < max_records) {
+            slot = pos & (set->nr_records - 1);
+            out = buf + (size_t)count * set->rec_size;
+
+            if (smp_load_acquire(&ring->seq[slot]) != pos + 1) {
+                lost++;
+                pos++;
+                continue;
+            }
+
+            memcpy(out, ring->buf + (size_t)slot * set->rec_size, set->rec_size);
+            smp_rmb();
+
+            if (READ_ONCE(ring->seq[slot]) != pos + 1)
+                lost++;
+            else
+                count++;
+            pos++;
+        }
+
+        cursor[cpu] = pos;
+    }
+
+    if (dropped)
+        *dropped = lost;
+
+    return count;
+}
@@ -0,0 +1,248 @@
+#include "xiao_syscall.h"
+
+static unsigned int xiao_sample_ms = 1000;
+module_param_named(sample_interval_ms, xiao_sample_ms, uint, 0644);
+MODULE_PARM_DESC(sample_interval_ms, "metrics sampler period in milliseconds (min 100)");
+
+struct xiao_history {
+    u64 ts[XIAO_HISTORY_LEN];
+    u64 val[XIAO_METRIC_MAX][XIAO_HISTORY_LEN];
+    u32 head;
+    u32 count;
+};
+
+struct xiao_sampler_state {
+    bool primed;
+    u64 ts;
+    u64 cpu_busy;
+    u64 cpu_total;
+    u64 net_rx;
+    u64 net_tx;
+};
+
+static DEFINE_SPINLOCK(xiao_sampler_lock);
+static struct xiao_history *xiao_history;
+static struct xiao_sampler_state xiao_sampler_last;
+static struct delayed_work xiao_sampler_work;
+
+static unsigned int xiao_sampler_interval(void)
+{
+    return max_t(unsigned int, READ_ONCE(xiao_sample_ms), XIAO_SAMPLE_MIN_MS);
+}
+
+static u32 xiao_count_processes(void)
+{
+    struct task_struct *task;
+    u32 nr = 0;
+
+    rcu_read_lock();
+    for_each_process(task)
+        nr++;
+    rcu_read_unlock();
+
+    return nr;
+}
+
+static u64 xiao_rate(u64 now, u64 last, u64 elapsed_ns)
+{
+    if (now < last || !elapsed_ns)
+        return 0;
+    return div64_u64((now - last) * NSEC_PER_SEC, elapsed_ns);
+}
+
+static void xiao_sampler_record(u64 ts, const u64 *val)
+{
+    u32 slot;
+    int i;
+
+    spin_lock(&xiao_sampler_lock);
+
+    slot = xiao_history->head;
+    xiao_history->ts[slot] = ts;
+    for (i = 0; i < XIAO_METRIC_MAX; i++)
+        xiao_history->val[i][slot] = val[i];
+
+    xiao_history->head = (slot + 1) % XIAO_HISTORY_LEN;
+    if (xiao_history->count < XIAO_HISTORY_LEN)
+        xiao_history->count++;
+
+    spin_unlock(&xiao_sampler_lock);
+}
+
+static void xiao_sampler_work_fn(struct work_struct *work)
+{
+    struct xiao_sampler_state now;
+    struct xiao_sampler_state *last = &xiao_sampler_last;
+    u64 val[XIAO_METRIC_MAX];
+    u64 elapsed;
+
+    now.ts = ktime_get_ns();
+    xiao_sys_cpu_totals(&now.cpu_busy, &now.cpu_total);
+    xiao_net_totals(&now.net_rx, &now.net_tx);
+    xiao_net_sample(now.ts);
+    xiao_disk_sample(now.ts);
+    xiao_sys_sample_psi();
+
+    /*
+     * Taking a CPU offline drops its time from the totals, so the counters
+     * can go backwards; such a tick only re-primes the baseline.
+     */
+    if (last->primed && now.ts > last->ts &&
+        now.cpu_busy >= last->cpu_busy && now.cpu_total >= last->cpu_total) {
+        elapsed = now.ts - last->ts;
+
+        val[XIAO_METRIC_CPU_BUSY] = now.cpu_total > last->cpu_total ?
+            min_t(u64, div64_u64((now.cpu_busy - last->cpu_busy) * 1000,
+                                 now.cpu_total - last->cpu_total), 1000) : 0;
+        val[XIAO_METRIC_MEM_USED] = xiao_sys_mem_used();
+        val[XIAO_METRIC_NET_RX] = xiao_rate(now.net_rx, last->net_rx, elapsed);
+        val[XIAO_METRIC_NET_TX] = xiao_rate(now.net_tx, last->net_tx, elapsed);
+        val[XIAO_METRIC_PROCS] = xiao_count_processes();
+
+        xiao_sampler_record(now.ts, val);
+    }
+
+    now.primed = true;
+    *last = now;
+
+    queue_delayed_work(system_power_efficient_wq, &xiao_sampler_work,
+                       msecs_to_jiffies(xiao_sampler_interval()));
+}
+
+int xiao_get_history(const struct xiao_history_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_history_header *hdr = buf;
+    struct xiao_sample *out = (struct xiao_sample *)(hdr + 1);
+    u32 max_out, step, count, avail, start, slot = 0;
+    u64 sum;
+    u32 i, j;
+
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    if (query->metric >= XIAO_METRIC_MAX)
+        return -EINVAL;
+
+    step = query->step ? query->step : 1;
+    max_out = (size - sizeof(*hdr)) / sizeof(*out);
+    if (query->count && query->count < max_out)
+        max_out = query->count;
+
+    spin_lock(&xiao_sampler_lock);
+
+    avail = xiao_history->count;
+    count = min(avail / step, max_out);
+
+    /* oldest sample of the most recent count * step window */
+    start = (xiao_history->head + XIAO_HISTORY_LEN - count * step) % XIAO_HISTORY_LEN;
+
+    for (i = 0; i < count; i++) {
+        sum = 0;
+        for (j = 0; j < step; j++) {
+            slot = (start + i * step + j) % XIAO_HISTORY_LEN;
+            sum += xiao_history->val[query->metric][slot];
+        }
+        out[i].timestamp = xiao_history->ts[slot];
+        out[i].value = div_u64(sum, step);
+    }
+
+    spin_unlock(&xiao_sampler_lock);
+
+    hdr->total = avail;
+    hdr->count = count;
+    hdr->interval_ms = xiao_sampler_interval();
+    hdr->step = step;
+    *data_len = sizeof(*hdr) + count * sizeof(*out);
+
+    return 0;
+}
+
+static int xiao_sampler_proc_show(struct seq_file *m, void *v)
+{
+    static const char * const names[XIAO_METRIC_MAX] = {
+        "cpu_busy_permille", "mem_used_bytes", "net_rx_bps", "net_tx_bps", "processes",
+    };
+    u64 latest[XIAO_METRIC_MAX] = {0};
+    u32 count, slot;
+    int i;
+
+    spin_lock(&xiao_sampler_lock);
+    count = xiao_history->count;
+    if (count) {
+        slot = (xiao_history->head + XIAO_HISTORY_LEN - 1) % XIAO_HISTORY_LEN;
+        for (i = 0; i < XIAO_METRIC_MAX; i++)
+            latest[i] = xiao_history->val[i][slot];
+    }
+    spin_unlock(&xiao_sampler_lock);
+
+    seq_printf(m, "xiao metrics sampler\n");
+    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "operations: get_history\n");
+
+    seq_printf(m, "\n--- Sampler ---\n");
+    seq_printf(m, "interval: %u ms\n", xiao_sampler_interval());
+    seq_printf(m, "samples: %u/%u\n", count, XIAO_HISTORY_LEN);
+
+    seq_printf(m, "\n--- Latest Sample ---\n");
+    for (i = 0; i < XIAO_METRIC_MAX; i++)
+        seq_printf(m, "%s: %llu\n", names[i], latest[i]);
+
+    return 0;
+}
+
+static int xiao_sampler_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, xiao_sampler_proc_show, NULL);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops xiao_sampler_proc_fops = {
+    .proc_open = xiao_sampler_proc_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+#else
+static const struct file_operations xiao_sampler_proc_fops = {
+    .owner = THIS_MODULE,
+    .open = xiao_sampler_proc_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+#endif
+
+static struct proc_dir_entry *xiao_sampler_proc_entry;
+
+int __init xiao_sampler_init(void)
+{
+    xiao_history = kvzalloc(sizeof(*xiao_history), GFP_KERNEL);
+    if (!xiao_history) {
+        pr_err("xiao_sampler: failed to allocate history buffer\n");
+        return -ENOMEM;
+    }
+
+    xiao_sampler_proc_entry = proc_create("xiao_sampler", 0444, NULL, &xiao_sampler_proc_fops);
+    if (!xiao_sampler_proc_entry) {
+        pr_err("xiao_sampler: failed to create proc entry\n");
+        kvfree(xiao_history);
+        return -ENOMEM;
+    }
+
+    INIT_DEFERRABLE_WORK(&xiao_sampler_work, xiao_sampler_work_fn);
+    queue_delayed_work(system_power_efficient_wq, &xiao_sampler_work, 0);
+
+    pr_info("xiao_sampler: metrics sampler initialized (%u ms)\n", xiao_sampler_interval());
+    return 0;
+}
+
+void __exit xiao_sampler_exit(void)
+{
+    cancel_delayed_work_sync(&xiao_sampler_work);
+
+    if (xiao_sampler_proc_entry)
+        remove_proc_entry("xiao_sampler", NULL);
+
+    kvfree(xiao_history);
+    pr_info("xiao_sampler: metrics sampler cleanup complete\n");
+}
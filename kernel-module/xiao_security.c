@@ -1,33 +1,86 @@
 #include "xiao_syscall.h"
 
-static DEFINE_MUTEX(xiao_security_lock);
-static unsigned long xiao_capabilities[256] = {0};
+/*
+ * Granted capabilities are kept per process in an RCU hash table keyed by
+ * tgid and start time, so a recycled pid never inherits a grant. Checks
+ * only take the RCU read lock; grants and exit cleanup serialize on
+ * xiao_security_lock.
+ */
+struct xiao_cap_entry {
+    struct hlist_node node;
+    struct rcu_head rcu;
+    pid_t tgid;
+    u64 start_time;
+    u32 caps;
+};
+
+static DEFINE_SPINLOCK(xiao_security_lock);
+static DEFINE_HASHTABLE(xiao_cap_table, XIAO_CAP_HASH_BITS);
+static atomic_t xiao_cap_entries = ATOMIC_INIT(0);
+static atomic_t xiao_cap_generation = ATOMIC_INIT(1);
+static struct tracepoint *xiao_cap_tp_exit;
 
 static inline int xiao_is_root(void)
 {
     return from_kuid(current_user_ns(), current_uid()) == 0;
 }
 
-static inline int xiao_cap_enabled(u32 caps)
+static inline u32 xiao_cap_hash(pid_t tgid, u64 start_time)
+{
+    return hash_32(tgid ^ (u32)start_time, XIAO_CAP_HASH_BITS);
+}
+
+/* Caller holds rcu_read_lock() or xiao_security_lock */
+static struct xiao_cap_entry *xiao_cap_lookup(pid_t tgid, u64 start_time)
+{
+    struct xiao_cap_entry *entry;
+
+    hash_for_each_possible_rcu(xiao_cap_table, entry, node, xiao_cap_hash(tgid, start_time)) {
+        if (entry->tgid == tgid && entry->start_time == start_time)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static XIAO_EXIT_PROBE(xiao_cap_exit_probe)
 {
-    return caps != 0;
+    struct xiao_cap_entry *entry;
+    u64 start_time;
+
+    if (!atomic_read(&xiao_cap_entries))
+        return;
+
+    /* Only the last thread of the group drops the grant */
+    if (atomic_read(&task->signal->live))
+        return;
+
+    start_time = task->group_leader->start_time;
+
+    xiao_spin_lock_traced(&xiao_security_lock, XIAO_LOCK_SECURITY);
+    entry = xiao_cap_lookup(task->tgid, start_time);
+    if (entry) {
+        hash_del_rcu(&entry->node);
+        atomic_dec(&xiao_cap_entries);
+        kfree_rcu(entry, rcu);
+    }
+    spin_unlock(&xiao_security_lock);
 }
 
 int xiao_check_capability(u32 pid, u32 caps)
 {
+    struct xiao_cap_entry *entry;
     struct task_struct *task;
-    kuid_t uid;
-    int ret = 0;
+    u32 granted = 0;
+    int ret;
 
     if (!caps)
         return 0;
 
-    mutex_lock(&xiao_security_lock);
+    if (xiao_is_root())
+        return 0;
 
-    if (xiao_is_root()) {
-        ret = 0;
-        goto out;
-    }
+    rcu_read_lock();
 
     task = pid_task(find_vpid(pid), PIDTYPE_PID);
     if (!task) {
@@ -35,71 +88,179 @@ int xiao_check_capability(u32 pid, u32 caps)
         goto out;
     }
 
-    uid = task_uid(task);
-    if (from_kuid(current_user_ns(), uid) == 0) {
+    if (from_kuid(current_user_ns(), task_uid(task)) == 0) {
         ret = 0;
         goto out;
     }
 
-    if (xiao_cap_enabled(caps)) {
-        if (test_bit(caps, xiao_capabilities)) {
-            ret = 0;
-        } else {
-            ret = -EACCES;
-        }
-    }
+    entry = xiao_cap_lookup(task->tgid, task->group_leader->start_time);
+    if (entry)
+        granted = READ_ONCE(entry->caps);
+
+    ret = (granted & caps) == caps ? 0 : -EACCES;
 
 out:
-    mutex_unlock(&xiao_security_lock);
+    rcu_read_unlock();
     return ret;
 }
 
-int xiao_request_capability(u32 pid, u32 requested_caps, u32 __user *granted_caps)
+int xiao_request_capability(u32 pid, u32 requested_caps, u32 *granted_caps)
 {
+    struct xiao_cap_entry *entry, *fresh;
     struct task_struct *task;
-    kuid_t uid;
+    u64 start_time;
+    pid_t tgid;
     u32 granted = 0;
-    int ret = 0;
+    bool task_root;
 
     if (!granted_caps)
         return -EINVAL;
 
-    mutex_lock(&xiao_security_lock);
-
+    rcu_read_lock();
     task = pid_task(find_vpid(pid), PIDTYPE_PID);
     if (!task) {
-        ret = -ESRCH;
-        goto out;
+        rcu_read_unlock();
+        xiao_audit_cap(XIAO_CMD_REQUEST_CAP, pid, 0, -ESRCH);
+        return -ESRCH;
+    }
+    tgid = task->tgid;
+    start_time = task->group_leader->start_time;
+    task_root = from_kuid(current_user_ns(), task_uid(task)) == 0;
+    rcu_read_unlock();
+
+    /* Unprivileged callers may only request for themselves */
+    if (tgid != current->tgid && !xiao_is_root()) {
+        xiao_audit_cap(XIAO_CMD_REQUEST_CAP, pid, 0, -EPERM);
+        return -EPERM;
     }
 
-    uid = task_uid(task);
-
-    if (from_kuid(current_user_ns(), uid) == 0) {
+    if (task_root || xiao_is_root())
         granted = requested_caps;
-    } else {
-        if (requested_caps & (XIAO_CAP_SYS_INFO | XIAO_CAP_HW_INFO))
-            granted |= requested_caps & (XIAO_CAP_SYS_INFO | XIAO_CAP_HW_INFO);
+    else
+        granted = requested_caps & (XIAO_CAP_SYS_INFO | XIAO_CAP_HW_INFO);
 
-        if (xiao_is_root()) {
-            granted = requested_caps;
+    if (granted) {
+        fresh = kzalloc(sizeof(*fresh), GFP_KERNEL);
+        if (!fresh)
+            return -ENOMEM;
+
+        xiao_spin_lock_traced(&xiao_security_lock, XIAO_LOCK_SECURITY);
+        entry = xiao_cap_lookup(tgid, start_time);
+        if (entry) {
+            WRITE_ONCE(entry->caps, entry->caps | granted);
+        } else if (atomic_read(&xiao_cap_entries) < XIAO_CAP_MAX_ENTRIES) {
+            fresh->tgid = tgid;
+            fresh->start_time = start_time;
+            fresh->caps = granted;
+            hash_add_rcu(xiao_cap_table, &fresh->node, xiao_cap_hash(tgid, start_time));
+            atomic_inc(&xiao_cap_entries);
+            fresh = NULL;
+        } else {
+            granted = 0;
+        }
+        if (granted)
+            atomic_inc(&xiao_cap_generation);
+        spin_unlock(&xiao_security_lock);
+
+        kfree(fresh);
+        if (!granted) {
+            xiao_audit_cap(XIAO_CMD_REQUEST_CAP, pid, 0, -ENOSPC);
+            return -ENOSPC;
         }
     }
 
-    if (granted) {
-        set_bit(granted, xiao_capabilities);
+    *granted_caps = granted;
+
+    /* A partially refused request is audited as a denial */
+    xiao_audit_cap(XIAO_CMD_REQUEST_CAP, pid, granted,
+                   granted == requested_caps ? 0 : -EACCES);
+
+    return 0;
+}
+
+int xiao_revoke_capability(u32 pid, u32 caps)
+{
+    struct xiao_cap_entry *entry;
+    struct task_struct *task;
+    u64 start_time;
+    pid_t tgid;
+
+    if (!xiao_is_root()) {
+        xiao_audit_cap(XIAO_CMD_REVOKE_CAP, pid, caps, -EPERM);
+        return -EPERM;
     }
 
-    if (copy_to_user(granted_caps, &granted, sizeof(granted))) {
-        ret = -EFAULT;
-        goto out;
+    rcu_read_lock();
+    task = pid_task(find_vpid(pid), PIDTYPE_PID);
+    if (!task) {
+        rcu_read_unlock();
+        xiao_audit_cap(XIAO_CMD_REVOKE_CAP, pid, caps, -ESRCH);
+        return -ESRCH;
     }
+    tgid = task->tgid;
+    start_time = task->group_leader->start_time;
+    rcu_read_unlock();
+
+    xiao_spin_lock_traced(&xiao_security_lock, XIAO_LOCK_SECURITY);
+    entry = xiao_cap_lookup(tgid, start_time);
+    if (entry)
+        WRITE_ONCE(entry->caps, entry->caps & ~caps);
+    atomic_inc(&xiao_cap_generation);
+    spin_unlock(&xiao_security_lock);
+
+    xiao_audit_cap(XIAO_CMD_REVOKE_CAP, pid, caps, 0);
+    return 0;
+}
 
-    pr_info("xiao_security: process %d requested caps 0x%08x, granted 0x%08x\n",
-            pid, requested_caps, granted);
+/*
+ * A session token packs the table generation it was computed at into the
+ * upper half and the opener's capability mask into the lower half, so it
+ * is read and replaced as a single atomic64_t. Refreshes always look up
+ * the identity recorded at open, never the task that happens to be
+ * calling, so a passed file descriptor keeps a single principal.
+ */
+static u64 xiao_session_token(const struct xiao_session *session)
+{
+    struct xiao_cap_entry *entry;
+    u32 generation, caps = 0;
 
-out:
-    mutex_unlock(&xiao_security_lock);
-    return ret;
+    generation = atomic_read(&xiao_cap_generation);
+
+    if (session->root)
+        return ((u64)generation << 32) | XIAO_CAP_ALL;
+
+    rcu_read_lock();
+    entry = xiao_cap_lookup(session->tgid, session->start_time);
+    if (entry)
+        caps = READ_ONCE(entry->caps);
+    rcu_read_unlock();
+
+    return ((u64)generation << 32) | caps;
+}
+
+void xiao_session_init(struct xiao_session *session)
+{
+    session->tgid = current->tgid;
+    session->start_time = current->group_leader->start_time;
+    /* uid 0 in a child user namespace is not enough for every capability */
+    session->root = ns_capable_noaudit(&init_user_ns, CAP_SYS_ADMIN);
+    atomic64_set(&session->token, xiao_session_token(session));
+}
+
+bool xiao_session_allows(struct xiao_session *session, u32 caps)
+{
+    u64 t;
+
+    if (!caps)
+        return true;
+
+    t = atomic64_read(&session->token);
+    if ((u32)(t >> 32) != (u32)atomic_read(&xiao_cap_generation)) {
+        t = xiao_session_token(session);
+        atomic64_set(&session->token, t);
+    }
+
+    return ((u32)t & caps) == caps;
 }
 
 int xiao_validate_path(const char *path)
@@ -149,22 +310,27 @@ out:
 
 static int xiao_security_proc_show(struct seq_file *m, void *v)
 {
-    int i;
+    struct xiao_cap_entry *entry;
+    int bkt;
 
     seq_printf(m, "xiao security bridge\n");
     seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
-    seq_printf(m, "operations: check_capability, request_capability, validate_path\n");
+    seq_printf(m, "operations: check_capability, request_capability, revoke_capability,\n");
+    seq_printf(m, "            validate_path\n");
 
     seq_printf(m, "\n--- Security Status ---\n");
     seq_printf(m, "Current UID: %d\n", from_kuid(current_user_ns(), current_uid()));
     seq_printf(m, "Is root: %s\n", xiao_is_root() ? "yes" : "no");
 
-    seq_printf(m, "\n--- Active Capabilities ---\n");
-    for (i = 0; i < 32; i++) {
-        if (test_bit(i, xiao_capabilities)) {
-            seq_printf(m, "Cap 0x%08x: enabled\n", 1 << i);
-        }
-    }
+    seq_printf(m, "exit cleanup: %s\n", xiao_cap_tp_exit ? "tracepoint" : "unavailable");
+    seq_printf(m, "generation: %d\n", atomic_read(&xiao_cap_generation));
+
+    seq_printf(m, "\n--- Granted Capabilities (%d processes) ---\n",
+               atomic_read(&xiao_cap_entries));
+    rcu_read_lock();
+    hash_for_each_rcu(xiao_cap_table, bkt, entry, node)
+        seq_printf(m, "tgid %d: 0x%08x\n", entry->tgid, READ_ONCE(entry->caps));
+    rcu_read_unlock();
 
     return 0;
 }
@@ -201,15 +367,11 @@ int __init xiao_security_init(void)
         return -ENOMEM;
     }
 
-    if (xiao_is_root()) {
-        set_bit(XIAO_CAP_FILE_READ, xiao_capabilities);
-        set_bit(XIAO_CAP_FILE_WRITE, xiao_capabilities);
-        set_bit(XIAO_CAP_PROC_LIST, xiao_capabilities);
-        set_bit(XIAO_CAP_PROC_KILL, xiao_capabilities);
-        set_bit(XIAO_CAP_SYS_INFO, xiao_capabilities);
-        set_bit(XIAO_CAP_NET_CONFIG, xiao_capabilities);
-        set_bit(XIAO_CAP_HW_INFO, xiao_capabilities);
-        set_bit(XIAO_CAP_IPC, xiao_capabilities);
+    xiao_cap_tp_exit = xiao_find_tracepoint("sched_process_exit");
+    if (!xiao_cap_tp_exit ||
+        tracepoint_probe_register(xiao_cap_tp_exit, xiao_cap_exit_probe, NULL)) {
+        pr_warn("xiao_security: exit tracepoint unavailable, grants kept until unload\n");
+        xiao_cap_tp_exit = NULL;
     }
 
     pr_info("xiao_security: security subsystem initialized\n");
@@ -219,8 +381,25 @@ int __init xiao_security_init(void)
 
 void __exit xiao_security_exit(void)
 {
+    struct xiao_cap_entry *entry;
+    struct hlist_node *tmp;
+    int bkt;
+
     if (xiao_security_proc_entry)
         remove_proc_entry("xiao_security", NULL);
-    memset(xiao_capabilities, 0, sizeof(xiao_capabilities));
+
+    if (xiao_cap_tp_exit) {
+        tracepoint_probe_unregister(xiao_cap_tp_exit, xiao_cap_exit_probe, NULL);
+        tracepoint_synchronize_unregister();
+    }
+
+    /* Wait for kfree_rcu() callbacks queued by the exit probe */
+    rcu_barrier();
+
+    hash_for_each_safe(xiao_cap_table, bkt, tmp, entry, node) {
+        hash_del(&entry->node);
+        kfree(entry);
+    }
+    atomic_set(&xiao_cap_entries, 0);
     pr_info("xiao_security: security subsystem cleanup complete\n");
 }
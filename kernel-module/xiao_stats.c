@@ -0,0 +1,182 @@
+#include "xiao_syscall.h"
+
+/*
+ * Per-command dispatch statistics. Each CPU owns a counter block per
+ * command, updated with preemption disabled and no atomics; the proc
+ * reader sums all CPUs and derives percentiles from the log2 latency
+ * buckets. Bucket b counts latencies in [2^(b-1), 2^b) ns.
+ */
+struct xiao_cmd_stats {
+    u64 calls;
+    u64 errors;
+    u64 bytes_in;
+    u64 bytes_out;
+    u64 hist[XIAO_STATS_BUCKETS];
+};
+
+struct xiao_cpu_stats {
+    struct xiao_cmd_stats cmds[XIAO_CMD_MAX];
+};
+
+static struct xiao_cpu_stats __percpu *xiao_stats;
+
+void xiao_stats_record(u32 cmd, s32 error, u32 bytes_in, u32 bytes_out, u64 latency_ns)
+{
+    struct xiao_cmd_stats *st;
+    u32 bucket;
+
+    if (!xiao_stats)
+        return;
+
+    /* Command 0 is unused and collects out-of-range requests */
+    if (cmd >= XIAO_CMD_MAX)
+        cmd = 0;
+
+    bucket = min_t(u32, fls64(latency_ns), XIAO_STATS_BUCKETS - 1);
+
+    st = &get_cpu_ptr(xiao_stats)->cmds[cmd];
+    st->calls++;
+    if (error < 0)
+        st->errors++;
+    st->bytes_in += bytes_in;
+    st->bytes_out += bytes_out;
+    st->hist[bucket]++;
+    put_cpu_ptr(xiao_stats);
+}
+
+static void xiao_stats_sum(u32 cmd, struct xiao_cmd_stats *sum)
+{
+    struct xiao_cmd_stats *st;
+    int cpu, b;
+
+    memset(sum, 0, sizeof(*sum));
+
+    for_each_possible_cpu(cpu) {
+        st = &per_cpu_ptr(xiao_stats, cpu)->cmds[cmd];
+        sum->calls += READ_ONCE(st->calls);
+        sum->errors += READ_ONCE(st->errors);
+        sum->bytes_in += READ_ONCE(st->bytes_in);
+        sum->bytes_out += READ_ONCE(st->bytes_out);
+        for (b = 0; b < XIAO_STATS_BUCKETS; b++)
+            sum->hist[b] += READ_ONCE(st->hist[b]);
+    }
+}
+
+/* Upper bound in ns of the bucket holding the pct-th percentile */
+static u64 xiao_stats_percentile(const struct xiao_cmd_stats *sum, u32 pct)
+{
+    u64 total = 0, seen = 0, rank;
+    int b;
+
+    for (b = 0; b < XIAO_STATS_BUCKETS; b++)
+        total += sum->hist[b];
+    if (!total)
+        return 0;
+
+    rank = div_u64(total * pct + 99, 100);
+    for (b = 0; b < XIAO_STATS_BUCKETS; b++) {
+        seen += sum->hist[b];
+        if (seen >= rank)
+            break;
+    }
+
+    return b ? 1ULL << b : 0;
+}
+
+static int xiao_stats_proc_show(struct seq_file *m, void *v)
+{
+    struct xiao_cmd_stats *sum;
+    u32 cmd;
+
+    seq_printf(m, "xiao dispatch statistics\n");
+    seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "reset: write to this file\n");
+
+    sum = kmalloc(sizeof(*sum), GFP_KERNEL);
+    if (!sum)
+        return -ENOMEM;
+
+    seq_printf(m, "\n%4s %12s %10s %14s %14s %12s %12s\n",
+               "cmd", "calls", "errors", "bytes_in", "bytes_out", "p50_ns", "p99_ns");
+
+    for (cmd = 0; cmd < XIAO_CMD_MAX; cmd++) {
+        xiao_stats_sum(cmd, sum);
+        if (!sum->calls)
+            continue;
+
+        seq_printf(m, "%4u %12llu %10llu %14llu %14llu %12llu %12llu\n",
+                   cmd, sum->calls, sum->errors, sum->bytes_in, sum->bytes_out,
+                   xiao_stats_percentile(sum, 50), xiao_stats_percentile(sum, 99));
+    }
+
+    kfree(sum);
+    return 0;
+}
+
+static int xiao_stats_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, xiao_stats_proc_show, NULL);
+}
+
+/* Counters racing with the reset may keep an in-flight increment */
+static ssize_t xiao_stats_proc_write(struct file *file, const char __user *buf,
+                                     size_t count, loff_t *ppos)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(xiao_stats, cpu), 0, sizeof(struct xiao_cpu_stats));
+
+    return count;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops xiao_stats_proc_fops = {
+    .proc_open = xiao_stats_proc_open,
+    .proc_read = seq_read,
+    .proc_write = xiao_stats_proc_write,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+#else
+static const struct file_operations xiao_stats_proc_fops = {
+    .owner = THIS_MODULE,
+    .open = xiao_stats_proc_open,
+    .read = seq_read,
+    .write = xiao_stats_proc_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+#endif
+
+static struct proc_dir_entry *xiao_stats_proc_entry;
+
+int __init xiao_stats_init(void)
+{
+    xiao_stats = alloc_percpu(struct xiao_cpu_stats);
+    if (!xiao_stats) {
+        pr_err("xiao_stats: failed to allocate counters\n");
+        return -ENOMEM;
+    }
+
+    xiao_stats_proc_entry = proc_create("xiao_stats", 0644, NULL, &xiao_stats_proc_fops);
+    if (!xiao_stats_proc_entry) {
+        pr_err("xiao_stats: failed to create proc entry\n");
+        free_percpu(xiao_stats);
+        xiao_stats = NULL;
+        return -ENOMEM;
+    }
+
+    pr_info("xiao_stats: dispatch statistics initialized\n");
+    return 0;
+}
+
+void __exit xiao_stats_exit(void)
+{
+    if (xiao_stats_proc_entry)
+        remove_proc_entry("xiao_stats", NULL);
+
+    free_percpu(xiao_stats);
+    xiao_stats = NULL;
+    pr_info("xiao_stats: dispatch statistics cleanup complete\n");
+}
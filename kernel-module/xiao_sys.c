@@ -1,65 +1,141 @@
 #include "xiao_syscall.h"
 
-static DEFINE_MUTEX(xiao_sys_lock);
+static void xiao_sys_cpu_stat(int cpu, u64 *stat)
+{
+    struct kernel_cpustat kcs;
+    u64 usecs;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 8, 0)
+    kcpustat_cpu_fetch(&kcs, cpu);
+#else
+    kcs = kcpustat_cpu(cpu);
+#endif
+    memcpy(stat, kcs.cpustat, sizeof(kcs.cpustat));
+
+    usecs = cpu_online(cpu) ? get_cpu_idle_time_us(cpu, NULL) : -1ULL;
+    if (usecs != -1ULL)
+        stat[CPUTIME_IDLE] = usecs * NSEC_PER_USEC;
+
+    usecs = cpu_online(cpu) ? get_cpu_iowait_time_us(cpu, NULL) : -1ULL;
+    if (usecs != -1ULL)
+        stat[CPUTIME_IOWAIT] = usecs * NSEC_PER_USEC;
+}
+
+static inline u64 xiao_ns_to_clock_t(u64 ns)
+{
+    return div_u64(ns, NSEC_PER_SEC / USER_HZ);
+}
+
+static u64 xiao_sys_cpu_freq(int cpu)
+{
+    unsigned int khz;
+
+    khz = cpufreq_quick_get(cpu);
+#ifdef CONFIG_X86
+    if (!khz)
+        khz = cpu_khz;
+#endif
+    return (u64)khz * 1000;
+}
+
+static void xiao_sys_fill_cpu_info(struct xiao_cpu_info *cinfo)
+{
+    u64 stat[NR_STATS];
+    u64 sum[NR_STATS] = {0};
+    int cpu, i;
+
+    memset(cinfo, 0, sizeof(*cinfo));
+
+    cinfo->num_cores = num_online_cpus();
+    cinfo->num_threads = num_possible_cpus();
+    cinfo->freq = xiao_sys_cpu_freq(cpumask_first(cpu_online_mask));
+
+#ifdef CONFIG_X86
+    strscpy(cinfo->model, boot_cpu_data.x86_model_id, sizeof(cinfo->model));
+#endif
+
+    for_each_possible_cpu(cpu) {
+        xiao_sys_cpu_stat(cpu, stat);
+        for (i = 0; i < NR_STATS; i++)
+            sum[i] += stat[i];
+    }
+
+    cinfo->user = xiao_ns_to_clock_t(sum[CPUTIME_USER]);
+    cinfo->nice = xiao_ns_to_clock_t(sum[CPUTIME_NICE]);
+    cinfo->system = xiao_ns_to_clock_t(sum[CPUTIME_SYSTEM]);
+    cinfo->idle = xiao_ns_to_clock_t(sum[CPUTIME_IDLE]);
+    cinfo->iowait = xiao_ns_to_clock_t(sum[CPUTIME_IOWAIT]);
+}
+
+static void xiao_sys_fill_mem_info(struct xiao_mem_info *minfo)
+{
+    struct sysinfo si;
+    long cached;
+
+    memset(minfo, 0, sizeof(*minfo));
+
+    si_meminfo(&si);
+
+    cached = global_node_page_state(NR_FILE_PAGES) - si.bufferram;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+    cached -= global_node_page_state(NR_SWAPCACHE);
+#endif
+    if (cached < 0)
+        cached = 0;
+
+    minfo->total = (u64)si.totalram * si.mem_unit;
+    minfo->free = (u64)si.freeram * si.mem_unit;
+    minfo->available = (u64)si_mem_available() << PAGE_SHIFT;
+    minfo->buffers = (u64)si.bufferram * si.mem_unit;
+    minfo->cached = (u64)cached << PAGE_SHIFT;
+
+#ifdef CONFIG_SWAP
+    si_swapinfo(&si);
+    minfo->swap_total = (u64)si.totalswap * si.mem_unit;
+    minfo->swap_free = (u64)si.freeswap * si.mem_unit;
+#endif
+}
+
+void xiao_sys_cpu_totals(u64 *busy, u64 *total)
+{
+    static const int busy_stats[] = {
+        CPUTIME_USER, CPUTIME_NICE, CPUTIME_SYSTEM,
+        CPUTIME_IRQ, CPUTIME_SOFTIRQ, CPUTIME_STEAL,
+    };
+    u64 stat[NR_STATS];
+    u64 b = 0, idle = 0;
+    int cpu, i;
+
+    for_each_possible_cpu(cpu) {
+        xiao_sys_cpu_stat(cpu, stat);
+        for (i = 0; i < ARRAY_SIZE(busy_stats); i++)
+            b += stat[busy_stats[i]];
+        idle += stat[CPUTIME_IDLE] + stat[CPUTIME_IOWAIT];
+    }
+
+    *busy = b;
+    *total = b + idle;
+}
+
+u64 xiao_sys_mem_used(void)
+{
+    struct sysinfo si;
+    u64 avail;
+
+    si_meminfo(&si);
+    avail = (u64)si_mem_available() << PAGE_SHIFT;
+
+    return (u64)si.totalram * si.mem_unit - min_t(u64, avail, (u64)si.totalram * si.mem_unit);
+}
 
 int xiao_get_cpu_info(struct xiao_cpu_info __user *info)
 {
     struct xiao_cpu_info cinfo;
-    struct file *fp;
-    char line[256];
-    char *p;
-    int ret;
 
     if (!info)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_SYS_INFO);
-    if (ret)
-        return ret;
-
-    memset(&cinfo, 0, sizeof(cinfo));
-
-    cinfo.num_cores = num_online_cpus();
-    cinfo.num_threads = num_possible_cpus();
-
-    fp = filp_open("/proc/cpuinfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "model name", 10) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    while (*p == ' ') p++;
-                    strncpy(cinfo.model, p, sizeof(cinfo.model) - 1);
-                    cinfo.model[strcspn(cinfo.model, "\n")] = 0;
-                }
-            }
-            if (strncmp(line, "cpu MHz", 7) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    kstrtou64(p, 10, &cinfo.freq);
-                    cinfo.freq *= 1000000;
-                }
-            }
-        }
-        filp_close(fp, NULL);
-    }
-
-    fp = filp_open("/proc/stat", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "cpu ", 4) == 0) {
-                sscanf(line + 4, "%llu %llu %llu %llu %llu",
-                       &cinfo.user, &cinfo.nice, &cinfo.system,
-                       &cinfo.idle, &cinfo.iowait);
-                break;
-            }
-        }
-        filp_close(fp, NULL);
-    }
+    xiao_sys_fill_cpu_info(&cinfo);
 
     if (copy_to_user(info, &cinfo, sizeof(cinfo)))
         return -EFAULT;
@@ -70,57 +146,11 @@ int xiao_get_cpu_info(struct xiao_cpu_info __user *info)
 int xiao_get_mem_info(struct xiao_mem_info __user *info)
 {
     struct xiao_mem_info minfo;
-    struct file *fp;
-    char line[256];
-    char *p;
-    int ret;
 
     if (!info)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_SYS_INFO);
-    if (ret)
-        return ret;
-
-    memset(&minfo, 0, sizeof(minfo));
-
-    fp = filp_open("/proc/meminfo", O_RDONLY, 0);
-    if (IS_ERR(fp))
-        return PTR_ERR(fp);
-
-    while (kernel_read(fp, line, sizeof(line) - 1, &fp->f_pos) > 0) {
-        if (strncmp(line, "MemTotal:", 9) == 0) {
-            p = line + 9;
-            kstrtou64(p, 10, &minfo.total);
-            minfo.total *= 1024;
-        } else if (strncmp(line, "MemFree:", 8) == 0) {
-            p = line + 8;
-            kstrtou64(p, 10, &minfo.free);
-            minfo.free *= 1024;
-        } else if (strncmp(line, "MemAvailable:", 13) == 0) {
-            p = line + 13;
-            kstrtou64(p, 10, &minfo.available);
-            minfo.available *= 1024;
-        } else if (strncmp(line, "Buffers:", 8) == 0) {
-            p = line + 8;
-            kstrtou64(p, 10, &minfo.buffers);
-            minfo.buffers *= 1024;
-        } else if (strncmp(line, "Cached:", 7) == 0) {
-            p = line + 7;
-            kstrtou64(p, 10, &minfo.cached);
-            minfo.cached *= 1024;
-        } else if (strncmp(line, "SwapTotal:", 10) == 0) {
-            p = line + 10;
-            kstrtou64(p, 10, &minfo.swap_total);
-            minfo.swap_total *= 1024;
-        } else if (strncmp(line, "SwapFree:", 9) == 0) {
-            p = line + 9;
-            kstrtou64(p, 10, &minfo.swap_free);
-            minfo.swap_free *= 1024;
-        }
-    }
-
-    filp_close(fp, NULL);
+    xiao_sys_fill_mem_info(&minfo);
 
     if (copy_to_user(info, &minfo, sizeof(minfo)))
         return -EFAULT;
@@ -128,65 +158,218 @@ int xiao_get_mem_info(struct xiao_mem_info __user *info)
     return 0;
 }
 
-int xiao_get_network_info(struct xiao_network_info __user *info, u32 max_count, u32 __user *count)
+/*
+ * PSI averages only move every two seconds, so the sampler refreshes this
+ * snapshot and GET_LOAD copies it instead of opening files on every call.
+ */
+struct xiao_psi_snapshot {
+    u32 flags;
+    u32 cpu_some[3];
+    u32 mem_some[3];
+    u32 mem_full[3];
+    u32 io_some[3];
+    u32 io_full[3];
+};
+
+static struct xiao_psi_snapshot xiao_psi_cache;
+static DEFINE_SPINLOCK(xiao_psi_lock);
+
+static int xiao_read_psi(const char *path, u32 *some, u32 *full)
 {
-    struct xiao_network_info ninfo;
-    struct net_device *dev;
-    struct in_device *in_dev;
-    struct ifinfomsg *ifi;
-    u32 count_val = 0;
-    int ret;
+    char buf[256];
+    unsigned int v[6];
+    const char *p;
+    ssize_t len;
+    int i;
+
+    len = xiao_kernel_read_init_file(path, buf, sizeof(buf));
+    if (len < 0)
+        return len;
+
+    p = strstr(buf, "some ");
+    if (!p || sscanf(p, "some avg10=%u.%u avg60=%u.%u avg300=%u.%u",
+                     &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+        return -EINVAL;
+    for (i = 0; i < 3; i++)
+        some[i] = v[i * 2] * 100 + v[i * 2 + 1];
+
+    p = strstr(buf, "full ");
+    if (full && p && sscanf(p, "full avg10=%u.%u avg60=%u.%u avg300=%u.%u",
+                            &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6) {
+        for (i = 0; i < 3; i++)
+            full[i] = v[i * 2] * 100 + v[i * 2 + 1];
+    }
 
-    if (!info || !count)
+    return 0;
+}
+
+void xiao_sys_sample_psi(void)
+{
+    struct xiao_psi_snapshot psi;
+
+    memset(&psi, 0, sizeof(psi));
+
+    if (xiao_read_psi("proc/pressure/cpu", psi.cpu_some, NULL) == 0)
+        psi.flags |= XIAO_PSI_CPU;
+    if (xiao_read_psi("proc/pressure/memory", psi.mem_some, psi.mem_full) == 0)
+        psi.flags |= XIAO_PSI_MEMORY;
+    if (xiao_read_psi("proc/pressure/io", psi.io_some, psi.io_full) == 0)
+        psi.flags |= XIAO_PSI_IO;
+
+    spin_lock(&xiao_psi_lock);
+    xiao_psi_cache = psi;
+    spin_unlock(&xiao_psi_lock);
+}
+
+static void xiao_sys_fill_load_info(struct xiao_load_info *linfo)
+{
+    unsigned long a;
+    int i;
+
+    memset(linfo, 0, sizeof(*linfo));
+
+    for (i = 0; i < 3; i++) {
+        a = READ_ONCE(avenrun[i]) + FIXED_1 / 200;
+        linfo->load[i] = LOAD_INT(a) * 100 + LOAD_FRAC(a);
+    }
+
+    linfo->uptime_ns = ktime_get_boottime_ns();
+
+    spin_lock(&xiao_psi_lock);
+    linfo->psi_flags = xiao_psi_cache.flags;
+    memcpy(linfo->cpu_some, xiao_psi_cache.cpu_some, sizeof(linfo->cpu_some));
+    memcpy(linfo->mem_some, xiao_psi_cache.mem_some, sizeof(linfo->mem_some));
+    memcpy(linfo->mem_full, xiao_psi_cache.mem_full, sizeof(linfo->mem_full));
+    memcpy(linfo->io_some, xiao_psi_cache.io_some, sizeof(linfo->io_some));
+    memcpy(linfo->io_full, xiao_psi_cache.io_full, sizeof(linfo->io_full));
+    spin_unlock(&xiao_psi_lock);
+}
+
+int xiao_get_load_info(struct xiao_load_info *info)
+{
+
+    if (!info)
         return -EINVAL;
 
-    ret = xiao_check_capability(current->pid, XIAO_CAP_SYS_INFO);
-    if (ret)
-        return ret;
+    xiao_sys_fill_load_info(info);
+    return 0;
+}
 
-    mutex_lock(&xiao_sys_lock);
+int xiao_get_cpu_detail(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_cpu_stat *cs = (struct xiao_cpu_stat *)(hdr + 1);
+    u64 stat[NR_STATS];
+    u32 max_out, count = 0;
+    int cpu;
 
-    rtnl_lock();
+    if (!query || !buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
 
-    for_each_netdev(&init_net, dev) {
-        if (count_val >= max_count)
-            break;
+    max_out = (size - sizeof(*hdr)) / sizeof(*cs);
+    if (query->max_count && query->max_count < max_out)
+        max_out = query->max_count;
 
-        if (dev->flags & IFF_LOOPBACK)
+    for_each_online_cpu(cpu) {
+        if (cpu < query->offset)
             continue;
+        if (count >= max_out)
+            break;
 
-        memset(&ninfo, 0, sizeof(ninfo));
-        strncpy(ninfo.name, dev->name, sizeof(ninfo.name) - 1);
+        xiao_sys_cpu_stat(cpu, stat);
+
+        cs->cpu = cpu;
+        cs->freq = cpufreq_quick_get(cpu);
+        cs->user = xiao_ns_to_clock_t(stat[CPUTIME_USER]);
+        cs->nice = xiao_ns_to_clock_t(stat[CPUTIME_NICE]);
+        cs->system = xiao_ns_to_clock_t(stat[CPUTIME_SYSTEM]);
+        cs->idle = xiao_ns_to_clock_t(stat[CPUTIME_IDLE]);
+        cs->iowait = xiao_ns_to_clock_t(stat[CPUTIME_IOWAIT]);
+        cs->irq = xiao_ns_to_clock_t(stat[CPUTIME_IRQ]);
+        cs->softirq = xiao_ns_to_clock_t(stat[CPUTIME_SOFTIRQ]);
+        cs->steal = xiao_ns_to_clock_t(stat[CPUTIME_STEAL]);
+        cs++;
+        count++;
+    }
 
-        in_dev = dev->ip_ptr;
-        if (in_dev && in_dev->ifa_list) {
-            snprintf(ninfo.ip, sizeof(ninfo.ip), "%pI4", &in_dev->ifa_list->ifa_address);
-            snprintf(ninfo.netmask, sizeof(ninfo.netmask), "%pI4",
-                     &in_dev->ifa_list->ifa_mask);
-        }
+    hdr->total = num_online_cpus();
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_cpu_stat);
 
-        if (dev->addr_len <= sizeof(ninfo.mac)) {
-            snprintf(ninfo.mac, sizeof(ninfo.mac), "%pM", dev->dev_addr);
-        }
+    return 0;
+}
+
+static unsigned long xiao_node_stat(struct pglist_data *pgdat, enum node_stat_item item)
+{
+    long x = atomic_long_read(&pgdat->vm_stat[item]);
+
+    return x < 0 ? 0 : x;
+}
 
-        ninfo.rx_bytes = dev->stats.rx_bytes;
-        ninfo.tx_bytes = dev->stats.tx_bytes;
-        ninfo.rx_packets = dev->stats.rx_packets;
-        ninfo.tx_packets = dev->stats.tx_packets;
-        ninfo.mtu = dev->mtu;
-        ninfo.flags = dev->flags;
-
-        if (copy_to_user(&info[count_val], &ninfo, sizeof(ninfo))) {
-            rtnl_unlock();
-            mutex_unlock(&xiao_sys_lock);
-            return -EFAULT;
+int xiao_get_numa_mem(void *buf, u32 size, u32 *data_len)
+{
+    struct xiao_list_header *hdr = buf;
+    struct xiao_numa_mem *nm = (struct xiao_numa_mem *)(hdr + 1);
+    struct pglist_data *pgdat;
+    struct zone *zone;
+    u32 max_out, count = 0;
+    int nid, z;
+
+    if (!buf || !data_len || size < sizeof(*hdr))
+        return -EINVAL;
+
+    max_out = (size - sizeof(*hdr)) / sizeof(*nm);
+
+    for_each_online_node(nid) {
+        if (count >= max_out)
+            break;
+
+        pgdat = NODE_DATA(nid);
+        memset(nm, 0, sizeof(*nm));
+        nm->node = nid;
+
+        for (z = 0; z < MAX_NR_ZONES; z++) {
+            zone = &pgdat->node_zones[z];
+            if (!populated_zone(zone))
+                continue;
+            nm->total += zone_managed_pages(zone);
+            nm->free += zone_page_state(zone, NR_FREE_PAGES);
         }
-        count_val++;
+
+        nm->used = nm->total > nm->free ? nm->total - nm->free : 0;
+        nm->file = xiao_node_stat(pgdat, NR_FILE_PAGES);
+        nm++;
+        count++;
     }
 
-    rtnl_unlock();
+    hdr->total = num_online_nodes();
+    hdr->count = count;
+    *data_len = sizeof(*hdr) + count * sizeof(struct xiao_numa_mem);
+
+    return 0;
+}
+
+int xiao_get_network_info(struct net *net, struct xiao_network_info __user *info, u32 max_count,
+                          u32 __user *count)
+{
+    struct xiao_network_info *ninfo;
+    u32 count_val;
+
+    if (!info || !count)
+        return -EINVAL;
+
+    ninfo = kcalloc(max_count, sizeof(*ninfo), GFP_KERNEL);
+    if (!ninfo)
+        return -ENOMEM;
+
+    count_val = xiao_net_snapshot(net, ninfo, max_count);
 
-    mutex_unlock(&xiao_sys_lock);
+    if (copy_to_user(info, ninfo, count_val * sizeof(*ninfo))) {
+        kfree(ninfo);
+        return -EFAULT;
+    }
+
+    kfree(ninfo);
 
     if (put_user(count_val, count))
         return -EFAULT;
@@ -198,52 +381,37 @@ static int xiao_sys_proc_show(struct seq_file *m, void *v)
 {
     struct xiao_cpu_info cinfo;
     struct xiao_mem_info minfo;
-    struct file *fp;
-    char line[256];
-    char *p;
+    struct xiao_load_info linfo;
+
+    xiao_sys_fill_cpu_info(&cinfo);
+    xiao_sys_fill_mem_info(&minfo);
+    xiao_sys_fill_load_info(&linfo);
 
     seq_printf(m, "xiao system info bridge\n");
     seq_printf(m, "version: %s\n", XIAO_MODULE_VERSION);
+    seq_printf(m, "operations: get_cpu_info, get_mem_info, get_cpu_detail, get_numa_mem, get_load\n");
 
     seq_printf(m, "\n--- CPU Information ---\n");
-
-    cinfo.num_cores = num_online_cpus();
-    cinfo.num_threads = num_possible_cpus();
     seq_printf(m, "CPU cores (online): %d\n", cinfo.num_cores);
     seq_printf(m, "CPU threads (possible): %d\n", cinfo.num_threads);
-
-    fp = filp_open("/proc/cpuinfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "model name", 10) == 0) {
-                p = strchr(line, ':');
-                if (p) {
-                    p++;
-                    while (*p == ' ') p++;
-                    seq_printf(m, "Model: %s", p);
-                }
-            }
-        }
-        filp_close(fp, NULL);
-    }
+    if (cinfo.model[0])
+        seq_printf(m, "Model: %s\n", cinfo.model);
+    seq_printf(m, "Frequency: %llu MHz\n", cinfo.freq / 1000000);
 
     seq_printf(m, "\n--- Memory Information ---\n");
-
-    fp = filp_open("/proc/meminfo", O_RDONLY, 0);
-    if (!IS_ERR(fp)) {
-        loff_t pos = 0;
-        while (kernel_read(fp, line, sizeof(line) - 1, &pos) > 0) {
-            if (strncmp(line, "MemTotal:", 9) == 0) {
-                seq_printf(m, "%s", line);
-            } else if (strncmp(line, "MemFree:", 8) == 0) {
-                seq_printf(m, "%s", line);
-            } else if (strncmp(line, "MemAvailable:", 13) == 0) {
-                seq_printf(m, "%s", line);
-            }
-        }
-        filp_close(fp, NULL);
-    }
+    seq_printf(m, "MemTotal:       %8llu kB\n", minfo.total >> 10);
+    seq_printf(m, "MemFree:        %8llu kB\n", minfo.free >> 10);
+    seq_printf(m, "MemAvailable:   %8llu kB\n", minfo.available >> 10);
+
+    seq_printf(m, "\n--- Load ---\n");
+    seq_printf(m, "Load average: %u.%02u %u.%02u %u.%02u\n",
+               linfo.load[0] / 100, linfo.load[0] % 100,
+               linfo.load[1] / 100, linfo.load[1] % 100,
+               linfo.load[2] / 100, linfo.load[2] % 100);
+    seq_printf(m, "Uptime: %llu s\n", div_u64(linfo.uptime_ns, NSEC_PER_SEC));
+    if (linfo.psi_flags & XIAO_PSI_CPU)
+        seq_printf(m, "CPU pressure (some avg10): %u.%02u%%\n",
+                   linfo.cpu_some[0] / 100, linfo.cpu_some[0] % 100);
 
     return 0;
 }
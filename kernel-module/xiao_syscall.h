@@ -21,6 +21,49 @@
 #include <linux/uaccess.h>
 #include <linux/errno.h>
 #include <linux/capability.h>
+#include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/tracepoint.h>
+#include <linux/sched/mm.h>
+#include <linux/sched/signal.h>
+#include <linux/sched/task.h>
+#include <linux/fdtable.h>
+#include <linux/fs_struct.h>
+#include <linux/cgroup.h>
+#include <linux/task_io_accounting_ops.h>
+#include <linux/idr.h>
+#include <linux/pid.h>
+#include <linux/sort.h>
+#include <linux/bsearch.h>
+#include <linux/kernel_stat.h>
+#include <linux/tick.h>
+#include <linux/cpufreq.h>
+#include <linux/vmstat.h>
+#include <linux/swap.h>
+#include <linux/mmzone.h>
+#include <linux/nodemask.h>
+#include <linux/workqueue.h>
+#include <linux/math64.h>
+#include <linux/sched/loadavg.h>
+#include <linux/timekeeping.h>
+#include <linux/dmi.h>
+#include <linux/utsname.h>
+#include <linux/delay.h>
+#include <linux/topology.h>
+#include <linux/cpumask.h>
+#include <linux/cpufeature.h>
+#include <linux/pci.h>
+#include <linux/usb.h>
+#include <linux/blkdev.h>
+#include <linux/hashtable.h>
+#include <linux/rculist.h>
+#include <linux/stringhash.h>
+#include <net/addrconf.h>
+#include <net/if_inet6.h>
+#include <net/tcp.h>
+#include <net/udp.h>
+#include <net/inet_hashtables.h>
 
 #define XIAO_MODULE_NAME "xiao_syscall"
 #define XIAO_MODULE_VERSION "1.0.0"
@@ -32,6 +75,32 @@
 #define XIAO_MAX_PATH 4096
 #define XIAO_MAX_PROCESSES 4096
 #define XIAO_BUFFER_SIZE 8192
+#define XIAO_EVENT_RING_SIZE 1024
+#define XIAO_AUDIT_RING_SIZE 1024
+#define XIAO_STATS_BUCKETS 32
+#define XIAO_CGROUP_PATH_LEN 256
+#define XIAO_AFFINITY_WORDS 4
+#define XIAO_MAX_HANDLES 1024
+#define XIAO_MAX_HANDLES_PER_OWNER 64
+#define XIAO_HANDLE_OWNER_BITS 6
+#define XIAO_HANDLE_WAIT_MAX_MS 1000
+#define XIAO_THREAD_SLACK 16
+#define XIAO_HISTORY_LEN 600
+#define XIAO_SAMPLE_MIN_MS 100
+#define XIAO_NET_MAX_IFACES 32
+#define XIAO_LINK_BATCH_MAX 64
+#define XIAO_SOCK_MAX_OWNED 1024
+#define XIAO_NOTIFY_DELAY_MS 50
+#define XIAO_CPU_MAX_CACHES 4
+#define XIAO_DEV_NAME_LEN 32
+#define XIAO_BLOCK_MAX_DEVS 256
+#define XIAO_DISK_MAX 64
+#define XIAO_DISK_RESCAN_MS 5000
+#define XIAO_THERMAL_MAX_TRIPS 8
+#define XIAO_THERMAL_MAX_ENTRIES 1024
+#define XIAO_THERMAL_INVALID S32_MIN
+#define XIAO_CAP_HASH_BITS 8
+#define XIAO_CAP_MAX_ENTRIES 4096
 
 #define XIAO_CMD_READ_FILE     1
 #define XIAO_CMD_WRITE_FILE    2
@@ -47,6 +116,113 @@
 #define XIAO_CMD_REQUEST_CAP   12
 #define XIAO_CMD_GET_NET_CONFIG 13
 #define XIAO_CMD_SET_NET_CONFIG 14
+#define XIAO_CMD_PROC_EVENTS_CTL 15
+#define XIAO_CMD_GET_PROC_EVENTS 16
+#define XIAO_CMD_GET_PROC_INFO_EX 17
+#define XIAO_CMD_OPEN_PROCESS  18
+#define XIAO_CMD_CLOSE_PROCESS 19
+#define XIAO_CMD_HANDLE_INFO   20
+#define XIAO_CMD_HANDLE_SIGNAL 21
+#define XIAO_CMD_HANDLE_WAIT   22
+#define XIAO_CMD_GET_THREADS   23
+#define XIAO_CMD_GET_CPU_DETAIL 24
+#define XIAO_CMD_GET_NUMA_MEM  25
+#define XIAO_CMD_GET_HISTORY   26
+#define XIAO_CMD_GET_LOAD      27
+#define XIAO_CMD_GET_NET_RATES 28
+#define XIAO_CMD_GET_NET_ADDRS 29
+#define XIAO_CMD_SET_LINK_CONFIG_BATCH 30
+#define XIAO_CMD_GET_SOCKETS   31
+#define XIAO_CMD_GET_CPU_TOPOLOGY 32
+#define XIAO_CMD_GET_PCI_DEVICES 33
+#define XIAO_CMD_GET_USB_DEVICES 34
+#define XIAO_CMD_GET_BLOCK_DEVICES 35
+#define XIAO_CMD_GET_DISK_STATS 36
+#define XIAO_CMD_GET_THERMAL   37
+#define XIAO_CMD_REVOKE_CAP    38
+#define XIAO_CMD_READ_AUDIT    39
+#define XIAO_CMD_MAX           40
+
+#define XIAO_NS_F_NET          0x0001
+
+/*
+ * Link events are multicast on NETLINK_USERSOCK group 1, which any local
+ * process may also send to; receivers must accept only sender portid 0.
+ */
+#define XIAO_NLMSG_LINK_EVENT  0x20
+
+#define XIAO_LINK_EV_REGISTER   0x0001
+#define XIAO_LINK_EV_UNREGISTER 0x0002
+#define XIAO_LINK_EV_UP         0x0004
+#define XIAO_LINK_EV_DOWN       0x0008
+#define XIAO_LINK_EV_CARRIER    0x0010
+#define XIAO_LINK_EV_MTU        0x0020
+#define XIAO_LINK_EV_RENAME     0x0040
+#define XIAO_LINK_EV_ADDR_ADD   0x0080
+#define XIAO_LINK_EV_ADDR_DEL   0x0100
+
+#define XIAO_PROC_EVENT_FORK   1
+#define XIAO_PROC_EVENT_EXEC   2
+#define XIAO_PROC_EVENT_EXIT   3
+
+#define XIAO_PROC_FIELD_THREADS  0x0001
+#define XIAO_PROC_FIELD_CTXSW    0x0002
+#define XIAO_PROC_FIELD_IO       0x0004
+#define XIAO_PROC_FIELD_FDS      0x0008
+#define XIAO_PROC_FIELD_PSS      0x0010
+#define XIAO_PROC_FIELD_CGROUP   0x0020
+#define XIAO_PROC_FIELD_AFFINITY 0x0040
+
+#define XIAO_THREAD_SORT_NONE  0
+#define XIAO_THREAD_SORT_CPU   1
+
+#define XIAO_METRIC_CPU_BUSY   0
+#define XIAO_METRIC_MEM_USED   1
+#define XIAO_METRIC_NET_RX     2
+#define XIAO_METRIC_NET_TX     3
+#define XIAO_METRIC_PROCS      4
+#define XIAO_METRIC_MAX        5
+
+#define XIAO_LINKCFG_STATE     0x0001
+#define XIAO_LINKCFG_MTU       0x0002
+
+#define XIAO_SOCK_PROTO_TCP    0x0001
+#define XIAO_SOCK_PROTO_UDP    0x0002
+
+#define XIAO_SOCK_FIELD_STATS  0x0001
+
+#define XIAO_SOCK_F_MORE        0x0001
+#define XIAO_SOCK_F_OWNED_TRUNC 0x0002
+
+#define XIAO_CACHE_INST        1
+#define XIAO_CACHE_DATA        2
+#define XIAO_CACHE_UNIFIED     3
+
+#define XIAO_ISA_SSE2          0x0001
+#define XIAO_ISA_SSE4_2        0x0002
+#define XIAO_ISA_AVX           0x0004
+#define XIAO_ISA_AVX2          0x0008
+#define XIAO_ISA_AVX512F       0x0010
+#define XIAO_ISA_AVX512BW      0x0020
+#define XIAO_ISA_FMA           0x0040
+#define XIAO_ISA_BMI2          0x0080
+#define XIAO_ISA_AES           0x0100
+#define XIAO_ISA_SHA           0x0200
+#define XIAO_ISA_NEON          0x1000
+#define XIAO_ISA_DOTPROD       0x2000
+#define XIAO_ISA_CRC32         0x4000
+#define XIAO_ISA_ATOMICS       0x8000
+#define XIAO_ISA_SVE           0x10000
+#define XIAO_ISA_SVE2          0x20000
+
+#define XIAO_TRIP_ACTIVE       0
+#define XIAO_TRIP_PASSIVE      1
+#define XIAO_TRIP_HOT          2
+#define XIAO_TRIP_CRITICAL     3
+
+#define XIAO_PSI_CPU           0x0001
+#define XIAO_PSI_MEMORY        0x0002
+#define XIAO_PSI_IO            0x0004
 
 #define XIAO_CAP_FILE_READ     0x0001
 #define XIAO_CAP_FILE_WRITE    0x0002
@@ -56,6 +232,7 @@
 #define XIAO_CAP_NET_CONFIG    0x0020
 #define XIAO_CAP_HW_INFO       0x0040
 #define XIAO_CAP_IPC           0x0080
+#define XIAO_CAP_ALL           0x00ff
 
 struct xiao_request {
     u32 cmd;
@@ -63,6 +240,8 @@ struct xiao_request {
     u32 uid;
     u32 pid;
     u32 data_len;
+    u32 ns_flags;
+    s32 netns_fd;
     char data[XIAO_MAX_PATH];
 };
 
@@ -93,6 +272,62 @@ struct xiao_process_info {
     char state_char;
 };
 
+struct xiao_process_info_ex {
+    struct xiao_process_info base;
+    u32 fields;
+    u32 nr_threads;
+    u64 nvcsw;
+    u64 nivcsw;
+    u64 read_bytes;
+    u64 write_bytes;
+    u64 pss;
+    u64 uss;
+    u32 nr_fds;
+    u32 reserved;
+    u64 cpus_allowed[XIAO_AFFINITY_WORDS];
+    char cgroup[XIAO_CGROUP_PATH_LEN];
+};
+
+struct xiao_handle_request {
+    u32 handle;
+    s32 sig;
+    u32 timeout_ms;
+};
+
+struct xiao_list_header {
+    u32 total;
+    u32 count;
+};
+
+struct xiao_page_query {
+    u32 offset;
+    u32 max_count;
+};
+
+struct xiao_thermal_query {
+    u32 zone_offset;
+    u32 zone_max;
+    u32 cpu_offset;
+    u32 cpu_max;
+};
+
+struct xiao_thread_query {
+    u32 pid;
+    u32 offset;
+    u32 max_count;
+    u32 sort;
+};
+
+struct xiao_thread_info {
+    u64 cpu_time;
+    u32 tid;
+    u32 last_cpu;
+    s32 prio;
+    s32 nice;
+    char state;
+    char comm[TASK_COMM_LEN];
+};
+
 struct xiao_cpu_info {
     u32 num_cores;
     u32 num_threads;
@@ -115,6 +350,58 @@ struct xiao_mem_info {
     u64 swap_free;
 };
 
+struct xiao_cpu_stat {
+    u32 cpu;
+    u32 freq;
+    u64 user;
+    u64 nice;
+    u64 system;
+    u64 idle;
+    u64 iowait;
+    u64 irq;
+    u64 softirq;
+    u64 steal;
+};
+
+struct xiao_numa_mem {
+    u32 node;
+    u32 reserved;
+    u64 total;
+    u64 free;
+    u64 used;
+    u64 file;
+};
+
+struct xiao_load_info {
+    u32 load[3];
+    u32 psi_flags;
+    u64 uptime_ns;
+    u32 cpu_some[3];
+    u32 mem_some[3];
+    u32 mem_full[3];
+    u32 io_some[3];
+    u32 io_full[3];
+    u32 reserved;
+};
+
+struct xiao_history_query {
+    u32 metric;
+    u32 count;
+    u32 step;
+};
+
+struct xiao_history_header {
+    u32 total;
+    u32 count;
+    u32 interval_ms;
+    u32 step;
+};
+
+struct xiao_sample {
+    u64 timestamp;
+    u64 value;
+};
+
 struct xiao_network_info {
     char name[32];
     char ip[16];
@@ -128,6 +415,108 @@ struct xiao_network_info {
     u32 flags;
 };
 
+struct xiao_net_rate {
+    char name[IFNAMSIZ];
+    u32 ifindex;
+    u32 reserved;
+    u64 rx_bps;
+    u64 tx_bps;
+    u64 rx_pps;
+    u64 tx_pps;
+    u64 rx_drops;
+    u64 tx_drops;
+};
+
+struct xiao_net_addr {
+    u32 ifindex;
+    u8 family;
+    u8 prefixlen;
+    u8 scope;
+    u8 reserved;
+    u32 flags;
+    u8 addr[16];
+    char ifname[IFNAMSIZ];
+};
+
+/*
+ * SET_LINK_CONFIG_BATCH covers link-level settings only: admin state and
+ * MTU. Addresses and routes are not part of the batch; any other mask bit
+ * is rejected with -EOPNOTSUPP before anything is changed.
+ */
+struct xiao_link_cfg_entry {
+    char ifname[IFNAMSIZ];
+    u32 mask;
+    u32 flags;
+    u32 mtu;
+    u32 reserved;
+};
+
+struct xiao_link_batch {
+    u32 count;
+    u32 reserved;
+    struct xiao_link_cfg_entry entries[];
+};
+
+struct xiao_link_batch_result {
+    u32 applied;
+    s32 failed_index;
+};
+
+struct xiao_socket_query {
+    u32 offset;
+    u32 max_count;
+    u32 pid;
+    u32 states;
+    u32 protocols;
+    u32 fields;
+    u16 port;
+    u16 reserved;
+};
+
+/*
+ * total counts matches up to the end of the page; when XIAO_SOCK_F_MORE is
+ * set the walk stopped early and further pages exist. XIAO_SOCK_F_OWNED_TRUNC
+ * means the pid held more than XIAO_SOCK_MAX_OWNED sockets and only the
+ * first ones were matched.
+ */
+struct xiao_socket_header {
+    u32 total;
+    u32 count;
+    u32 flags;
+    u32 reserved;
+};
+
+struct xiao_socket_info {
+    u8 family;
+    u8 protocol;
+    u8 state;
+    u8 reserved;
+    u16 sport;
+    u16 dport;
+    u8 saddr[16];
+    u8 daddr[16];
+    u32 uid;
+    u32 fields;
+    u32 rtt_us;
+    u32 rx_queue;
+    u32 tx_queue;
+};
+
+struct xiao_link_event {
+    u64 timestamp;
+    u32 ifindex;
+    u32 events;
+    u32 flags;
+    u32 mtu;
+    char name[IFNAMSIZ];
+};
+
+struct xiao_link_event_batch {
+    u32 count;
+    u32 overflow;
+    struct xiao_link_event events[];
+};
+
 struct xiao_hw_info {
     char vendor[64];
     char model[64];
@@ -135,6 +524,197 @@ struct xiao_hw_info {
     u64 mem_total;
     u32 num_cpus;
     u64 bogomips;
+    char cpu_vendor[16];
+    char cpu_model[64];
+    char board_name[64];
+    char bios_date[32];
+    u32 cpu_family;
+    u32 cpu_model_id;
+    u32 cpu_stepping;
+    u32 reserved;
+};
+
+struct xiao_cache_desc {
+    u8 level;
+    u8 type;
+    u16 ways;
+    u32 size;
+    u32 line_size;
+    u32 shared_cpus;
+};
+
+struct xiao_cpu_topology {
+    u32 cpu;
+    u32 online;
+    s32 package_id;
+    s32 die_id;
+    s32 core_id;
+    s32 node;
+    u32 smt_siblings;
+    u32 core_siblings;
+    u32 nr_caches;
+    u32 reserved;
+    struct xiao_cache_desc caches[XIAO_CPU_MAX_CACHES];
+};
+
+struct xiao_topology_header {
+    u32 total;
+    u32 count;
+    u64 isa_flags;
+};
+
+struct xiao_pci_device {
+    u32 domain;
+    u8 bus;
+    u8 devfn;
+    u16 vendor;
+    u16 device;
+    u16 subsystem_vendor;
+    u16 subsystem_device;
+    u8 revision;
+    u8 reserved;
+    u32 class;
+    char driver[32];
+};
+
+struct xiao_usb_device {
+    u16 vendor;
+    u16 product;
+    u16 bcd_device;
+    u8 busnum;
+    u8 devnum;
+    u8 dev_class;
+    u8 dev_subclass;
+    u8 dev_protocol;
+    u8 speed;
+    char manufacturer[32];
+    char name[32];
+    char driver[32];
+};
+
+struct xiao_block_device {
+    char name[XIAO_DEV_NAME_LEN];
+    u64 capacity;
+    u32 logical_block_size;
+    u32 physical_block_size;
+    u32 nr_requests;
+    u8 rotational;
+    u8 removable;
+    u8 read_only;
+    u8 reserved;
+    char scheduler[16];
+    char model[32];
+};
+
+struct xiao_disk_stat {
+    char name[XIAO_DEV_NAME_LEN];
+    u64 reads;
+    u64 read_sectors;
+    u64 read_ticks_ms;
+    u64 writes;
+    u64 write_sectors;
+    u64 write_ticks_ms;
+    u64 io_ticks_ms;
+    u32 in_flight;
+    u32 util_permille;
+    u64 read_bps;
+    u64 write_bps;
+    u32 read_iops;
+    u32 write_iops;
+    u32 read_lat_us;
+    u32 write_lat_us;
+};
+
+struct xiao_thermal_trip {
+    s32 temp;
+    u32 type;
+};
+
+struct xiao_thermal_zone {
+    char type[20];
+    u32 id;
+    s32 temp;
+    u32 nr_trips;
+    struct xiao_thermal_trip trips[XIAO_THERMAL_MAX_TRIPS];
+};
+
+struct xiao_cpu_freq {
+    u32 cpu;
+    u32 cur_khz;
+    u32 min_khz;
+    u32 max_khz;
+    u32 hw_min_khz;
+    u32 hw_max_khz;
+    char governor[CPUFREQ_NAME_LEN];
+};
+
+struct xiao_thermal_header {
+    u32 nr_zones;
+    u32 nr_cpus;
+    u32 total_cpus;
+    u32 nr_zones_total;
+};
+
+struct xiao_proc_event {
+    u64 timestamp;
+    u32 type;
+    u32 pid;
+    u32 tgid;
+    u32 ppid;
+    s32 exit_code;
+    u32 cpu;
+    char comm[TASK_COMM_LEN];
+};
+
+struct xiao_proc_event_batch {
+    u32 count;
+    u32 dropped;
+    struct xiao_proc_event events[];
+};
+
+struct xiao_audit_record {
+    u64 timestamp;
+    u32 pid;
+    u32 uid;
+    u32 cmd;
+    u32 path_hash;
+    u32 target_pid;
+    u32 caps;
+    s32 verdict;
+    u32 cpu;
+};
+
+struct xiao_audit_batch {
+    u32 count;
+    u32 dropped;
+    struct xiao_audit_record records[];
+};
+
+struct xiao_ring {
+    u32 head;
+    u32 tail;
+    u32 dropped;
+    u32 dropped_seen;
+    char *buf;
+};
+
+struct xiao_bcast_ring {
+    unsigned long head;
+    unsigned long *seq;
+    char *buf;
+};
+
+struct xiao_bcast_set {
+    struct xiao_bcast_ring __percpu *cpus;
+    u32 nr_records;
+    u32 rec_size;
+};
+
+struct xiao_ring_set {
+    struct xiao_ring __percpu *cpus;
+    struct mutex read_lock;
+    u32 nr_records;
+    u32 rec_size;
 };
 
 struct xiao_capability {
@@ -145,6 +725,25 @@ struct xiao_capability {
     u32 uid;
 };
 
+/* sched_process_exit gained a group_dead argument in 6.16 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+#define XIAO_EXIT_PROBE(name) \
+    void name(void *data, struct task_struct *task, bool group_dead)
+#else
+#define XIAO_EXIT_PROBE(name) \
+    void name(void *data, struct task_struct *task)
+#endif
+
+struct xiao_event_sub;
+
+struct xiao_session {
+    pid_t tgid;
+    bool root;
+    u64 start_time;
+    atomic64_t token;
+    struct xiao_event_sub *events;
+};
+
 extern struct mutex xiao_global_lock;
 
 int xiao_fs_init(void);
@@ -152,38 +751,112 @@ void xiao_fs_exit(void);
 int xiao_read_file(const char __user *path, char __user *buf, size_t count, loff_t *offset);
 int xiao_write_file(const char __user *path, const char __user *buf, size_t count, loff_t *offset);
 int xiao_list_dir(const char __user *path, char __user *buf, size_t count);
+ssize_t xiao_kernel_read_file(const char *path, char *buf, size_t size);
+ssize_t xiao_kernel_read_init_file(const char *path, char *buf, size_t size);
+int xiao_kernel_list_names(const char *path, char (*names)[XIAO_DEV_NAME_LEN], u32 max, u32 *count);
 
 int xiao_proc_init(void);
 void xiao_proc_exit(void);
 int xiao_get_processes(struct xiao_process_info __user *buf, u32 max_count, u32 __user *count);
 int xiao_kill_process(u32 pid, int sig);
 int xiao_get_process_info(u32 pid, struct xiao_process_info __user *info);
+int xiao_get_process_info_ex(u32 pid, u32 fields, struct xiao_process_info_ex *info);
+int xiao_open_process(u32 pid, u32 *handle);
+int xiao_close_process(u32 handle);
+int xiao_handle_get_info(u32 handle, struct xiao_process_info *info);
+int xiao_handle_signal(u32 handle, int sig);
+int xiao_handle_wait(u32 handle, u32 timeout_ms);
+int xiao_get_threads(const struct xiao_thread_query *query, void *buf, u32 size, u32 *data_len);
+
+int xiao_ring_init(struct xiao_ring_set *set, u32 nr_records, u32 rec_size);
+void xiao_ring_free(struct xiao_ring_set *set);
+bool xiao_ring_write(struct xiao_ring_set *set, const void *rec);
+u32 xiao_ring_drain(struct xiao_ring_set *set, void *buf, u32 max_records, u32 *dropped);
+u32 xiao_ring_pending(struct xiao_ring_set *set);
+int xiao_bcast_init(struct xiao_bcast_set *set, u32 nr_records, u32 rec_size);
+void xiao_bcast_free(struct xiao_bcast_set *set);
+void xiao_bcast_write(struct xiao_bcast_set *set, const void *rec);
+unsigned long *xiao_bcast_cursor_alloc(struct xiao_bcast_set *set);
+u32 xiao_bcast_read(struct xiao_bcast_set *set, unsigned long *cursor, void *buf,
+                    u32 max_records, u32 *dropped);
+
+int xiao_event_init(void);
+void xiao_event_exit(void);
+struct tracepoint *xiao_find_tracepoint(const char *name);
+int xiao_proc_events_ctl(struct xiao_session *session, u32 portid, u32 enable);
+int xiao_get_proc_events(struct xiao_session *session, u32 portid,
+                         struct xiao_proc_event_batch *batch, u32 size, u32 *data_len);
 
 int xiao_sys_init(void);
 void xiao_sys_exit(void);
 int xiao_get_cpu_info(struct xiao_cpu_info __user *info);
 int xiao_get_mem_info(struct xiao_mem_info __user *info);
-int xiao_get_network_info(struct xiao_network_info __user *info, u32 max_count, u32 __user *count);
+int xiao_get_cpu_detail(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+int xiao_get_numa_mem(void *buf, u32 size, u32 *data_len);
+void xiao_sys_cpu_totals(u64 *busy, u64 *total);
+u64 xiao_sys_mem_used(void);
+int xiao_get_load_info(struct xiao_load_info *info);
+void xiao_sys_sample_psi(void);
+int xiao_get_network_info(struct net *net, struct xiao_network_info __user *info, u32 max_count,
+                          u32 __user *count);
 
 int xiao_security_init(void);
 void xiao_security_exit(void);
 int xiao_check_capability(u32 pid, u32 caps);
-int xiao_request_capability(u32 pid, u32 requested_caps, u32 __user *granted_caps);
+int xiao_request_capability(u32 pid, u32 requested_caps, u32 *granted_caps);
+int xiao_revoke_capability(u32 pid, u32 caps);
+void xiao_session_init(struct xiao_session *session);
+bool xiao_session_allows(struct xiao_session *session, u32 caps);
 int xiao_validate_path(const char *path);
 
+int xiao_audit_init(void);
+void xiao_audit_exit(void);
+void xiao_audit_command(const struct xiao_request *req, u32 caps, s32 verdict);
+void xiao_audit_cap(u32 cmd, u32 target_pid, u32 caps, s32 verdict);
+int xiao_read_audit(struct xiao_audit_batch *batch, u32 size, u32 *data_len);
+
+int xiao_stats_init(void);
+void xiao_stats_exit(void);
+void xiao_stats_record(u32 cmd, s32 error, u32 bytes_in, u32 bytes_out, u64 latency_ns);
+
 int xiao_net_init(void);
 void xiao_net_exit(void);
-int xiao_get_net_config(struct xiao_network_info __user *info, u32 max_count, u32 __user *count);
-int xiao_set_net_config(const char __user *ifname, u32 flags);
+void xiao_net_notify_cancel(void);
+int xiao_get_net_config(struct net *net, struct xiao_network_info __user *info, u32 max_count,
+                        u32 __user *count);
+int xiao_set_net_config(struct net *net, const char __user *ifname, u32 flags);
+void xiao_net_totals(u64 *rx_bytes, u64 *tx_bytes);
+u32 xiao_net_snapshot(struct net *net, struct xiao_network_info *info, u32 max_count);
+struct net *xiao_net_resolve(const struct xiao_request *req);
+void xiao_net_sample(u64 now_ns);
+int xiao_get_net_rates(void *buf, u32 size, u32 *data_len);
+int xiao_get_net_addrs(struct net *net, const struct xiao_page_query *query, void *buf, u32 size,
+                       u32 *data_len);
+int xiao_get_sockets(struct net *net, const struct xiao_socket_query *query, void *buf, u32 size,
+                     u32 *data_len);
+int xiao_set_link_config_batch(struct net *net, const struct xiao_link_batch *batch, u32 len,
+                               struct xiao_link_batch_result *result, u32 *data_len);
 
 int xiao_hardware_init(void);
 void xiao_hardware_exit(void);
-int xiao_get_hw_info(struct xiao_hw_info __user *info);
+int xiao_get_hw_info(struct xiao_hw_info *info);
+int xiao_get_cpu_topology(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+int xiao_get_pci_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+int xiao_get_usb_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+int xiao_get_block_devices(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+int xiao_get_disk_stats(const struct xiao_page_query *query, void *buf, u32 size, u32 *data_len);
+void xiao_disk_sample(u64 now_ns);
+int xiao_get_thermal(const struct xiao_thermal_query *query, void *buf, u32 size, u32 *data_len);
+
+int xiao_sampler_init(void);
+void xiao_sampler_exit(void);
+int xiao_get_history(const struct xiao_history_query *query, void *buf, u32 size, u32 *data_len);
 
 int xiao_ipc_init(void);
 void xiao_ipc_exit(void);
 int xiao_handle_netlink(struct sk_buff *skb);
 int xiao_send_netlink_response(struct sk_buff *skb, struct xiao_response *resp);
+int xiao_ipc_broadcast(u16 type, const void *data, u32 len);
 
 ssize_t xiao_proc_read(struct file *file, char __user *buf, size_t count, loff_t *ppos);
 ssize_t xiao_proc_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos);
@@ -207,4 +880,45 @@ static const struct file_operations xiao_proc_fops = {
 };
 #endif
 
+#include "xiao_trace.h"
+
+/*
+ * Lock helpers for the subsystem locks that report contended waits through
+ * the xiao_lock_wait tracepoint. With the event disabled they reduce to a
+ * static branch and the plain lock call.
+ */
+static inline void xiao_mutex_lock_traced(struct mutex *lock, u32 id)
+{
+    u64 start;
+
+    if (!trace_xiao_lock_wait_enabled()) {
+        mutex_lock(lock);
+        return;
+    }
+
+    if (mutex_trylock(lock))
+        return;
+
+    start = ktime_get_ns();
+    mutex_lock(lock);
+    trace_xiao_lock_wait(id, ktime_get_ns() - start);
+}
+
+static inline void xiao_spin_lock_traced(spinlock_t *lock, u32 id)
+{
+    u64 start;
+
+    if (!trace_xiao_lock_wait_enabled()) {
+        spin_lock(lock);
+        return;
+    }
+
+    if (spin_trylock(lock))
+        return;
+
+    start = ktime_get_ns();
+    spin_lock(lock);
+    trace_xiao_lock_wait(id, ktime_get_ns() - start);
+}
+
 #endif
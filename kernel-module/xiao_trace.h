@@ -0,0 +1,117 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xiao
+
+#if !defined(_XIAO_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _XIAO_TRACE_H
+
+#include <linux/tracepoint.h>
+
+#define XIAO_TRACE_SRC_PROC    0
+#define XIAO_TRACE_SRC_NETLINK 1
+
+#define XIAO_LOCK_FS       0
+#define XIAO_LOCK_PROC     1
+#define XIAO_LOCK_NET      2
+#define XIAO_LOCK_SECURITY 3
+
+#define xiao_show_lock(id)                          \
+    __print_symbolic(id,                            \
+        { XIAO_LOCK_FS, "xiao_fs_lock" },           \
+        { XIAO_LOCK_PROC, "xiao_proc_lock" },       \
+        { XIAO_LOCK_NET, "xiao_net_lock" },         \
+        { XIAO_LOCK_SECURITY, "xiao_security_lock" })
+
+/* A request has been received, before any permission check */
+TRACE_EVENT(xiao_cmd_submit,
+
+    TP_PROTO(u32 cmd, u32 pid, u32 len, u32 source),
+
+    TP_ARGS(cmd, pid, len, source),
+
+    TP_STRUCT__entry(
+        __field(u32, cmd)
+        __field(u32, pid)
+        __field(u32, len)
+        __field(u32, source)
+    ),
+
+    TP_fast_assign(
+        __entry->cmd = cmd;
+        __entry->pid = pid;
+        __entry->len = len;
+        __entry->source = source;
+    ),
+
+    TP_printk("cmd=%u pid=%u len=%u source=%s",
+              __entry->cmd, __entry->pid, __entry->len,
+              __entry->source == XIAO_TRACE_SRC_NETLINK ? "netlink" : "proc")
+);
+
+/* The request passed its checks and enters the dispatch switch */
+TRACE_EVENT(xiao_cmd_start,
+
+    TP_PROTO(u32 cmd),
+
+    TP_ARGS(cmd),
+
+    TP_STRUCT__entry(
+        __field(u32, cmd)
+    ),
+
+    TP_fast_assign(
+        __entry->cmd = cmd;
+    ),
+
+    TP_printk("cmd=%u", __entry->cmd)
+);
+
+/* The reply is ready; latency is measured from submit */
+TRACE_EVENT(xiao_cmd_done,
+
+    TP_PROTO(u32 cmd, s32 error, u64 latency_ns),
+
+    TP_ARGS(cmd, error, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(u32, cmd)
+        __field(s32, error)
+        __field(u64, latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->cmd = cmd;
+        __entry->error = error;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("cmd=%u error=%d latency_ns=%llu",
+              __entry->cmd, __entry->error, __entry->latency_ns)
+);
+
+/* Emitted only when the lock was contended */
+TRACE_EVENT(xiao_lock_wait,
+
+    TP_PROTO(u32 lock, u64 wait_ns),
+
+    TP_ARGS(lock, wait_ns),
+
+    TP_STRUCT__entry(
+        __field(u32, lock)
+        __field(u64, wait_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->lock = lock;
+        __entry->wait_ns = wait_ns;
+    ),
+
+    TP_printk("lock=%s wait_ns=%llu", xiao_show_lock(__entry->lock), __entry->wait_ns)
+);
+
+#endif /* _XIAO_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xiao_trace
+#include <trace/define_trace.h>